@@ -0,0 +1,58 @@
+// False positive rate and lookup throughput of the Bloom filters.
+//
+//   g++ -std=c++23 -O2 bench/bloom_filter_bench.cpp -o bloom_bench
+#include "../bloom_filter.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t queries = 1 << 22;
+
+// 10 bits per key
+template <class Filter> void run(const char *name) {
+  const std::size_t keys = Filter::bitset_type::size() / 10;
+  const auto filter = std::make_unique<Filter>();
+  for (std::uint64_t i = 0; i < keys; ++i)
+    filter->insert(i);
+
+  std::size_t false_negatives = 0;
+  for (std::uint64_t i = 0; i < keys; ++i)
+    false_negatives += !filter->contains(i);
+
+  // none of these were inserted, so every hit is a false positive
+  std::vector<std::uint64_t> absent(queries);
+  for (std::size_t i = 0; i < queries; ++i)
+    absent[i] = keys + i * 0x9e3779b97f4a7c15ull;
+
+  std::size_t hits = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (const std::uint64_t key : absent)
+    hits += filter->contains(key);
+  const std::chrono::duration<double, std::nano> single =
+      std::chrono::steady_clock::now() - start;
+
+  const auto out = std::make_unique<bool[]>(queries);
+  start = std::chrono::steady_clock::now();
+  filter->contains_n(absent.data(), queries, out.get());
+  const std::chrono::duration<double, std::nano> batch =
+      std::chrono::steady_clock::now() - start;
+
+  std::printf("%-12s %6zu KiB  fpr %.3f%%  false negatives %zu  contains %.1f ns  "
+              "contains_n %.1f ns\n",
+              name, Filter::bitset_type::size() / 8192, 100.0 * hits / queries, false_negatives,
+              single.count() / queries, batch.count() / queries);
+}
+
+} // namespace
+
+int main() {
+  // in cache, then well beyond it where contains_n's prefetching matters
+  run<eden::BloomFilter<(1 << 20), 7>>("blocked");
+  run<eden::SplitBlockBloomFilter<(1 << 20)>>("split block");
+  run<eden::BloomFilter<(1 << 28), 7>>("blocked");
+  run<eden::SplitBlockBloomFilter<(1 << 28)>>("split block");
+}
@@ -0,0 +1,113 @@
+// flat_hash_map against std::unordered_map, plus probe-length statistics.
+//
+//   g++ -std=c++23 -O2 bench/flat_hash_map_bench.cpp -o hash_bench
+#include "../flat_hash_map.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+volatile std::uint64_t sink;
+
+template <class F> double time_ns(std::size_t per, F &&f) {
+  double best = 1e300;
+  for (int r = 0; r < 5; ++r) {
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    const std::chrono::duration<double, std::nano> took =
+        std::chrono::steady_clock::now() - start;
+    best = std::min(best, took.count() / per);
+  }
+  return best;
+}
+
+template <class Map, class Key>
+void run(const char *name, const std::vector<Key> &present,
+         const std::vector<Key> &absent) {
+  const std::size_t n = present.size();
+
+  const double insert = time_ns(n, [&] {
+    Map map;
+    for (const Key &key : present)
+      map[key] = 1;
+    sink = map.size();
+  });
+
+  const double insert_reserved = time_ns(n, [&] {
+    Map map;
+    map.reserve(n);
+    for (const Key &key : present)
+      map[key] = 1;
+    sink = map.size();
+  });
+
+  Map map;
+  for (const Key &key : present)
+    map[key] = 1;
+
+  const double hit = time_ns(n, [&] {
+    std::uint64_t total = 0;
+    for (const Key &key : present)
+      total += map.find(key)->second;
+    sink = total;
+  });
+
+  const double miss = time_ns(n, [&] {
+    std::uint64_t total = 0;
+    for (const Key &key : absent)
+      total += map.find(key) != map.end();
+    sink = total;
+  });
+
+  // erase and re-insert half the keys, which leaves tombstones behind
+  const double churn = time_ns(n, [&] {
+    for (std::size_t i = 0; i < n; i += 2)
+      map.erase(present[i]);
+    for (std::size_t i = 0; i < n; i += 2)
+      map[present[i]] = 1;
+  });
+
+  std::printf("%-22s %8zu  insert %6.1f  reserved %6.1f  hit %6.1f  "
+              "miss %6.1f  churn %6.1f ns\n",
+              name, n, insert, insert_reserved, hit, miss, churn);
+
+  if constexpr (requires { map.probe_stats(); }) {
+    const eden::probe_statistics stats = map.probe_stats();
+    std::printf("%22s capacity %zu  tombstones %zu  mean probe %.3f  "
+                "max probe %zu groups\n",
+                "", stats.m_capacity, stats.m_tombstones,
+                stats.m_mean_probe_length, stats.m_max_probe_length);
+  }
+}
+
+template <class Key, class Make> void suite(const char *type, Make make) {
+  for (const std::size_t n : {std::size_t{1} << 10, std::size_t{1} << 20}) {
+    std::mt19937_64 rng(n);
+    std::vector<Key> present, absent;
+    for (std::size_t i = 0; i < n; ++i) {
+      present.push_back(make(rng()));
+      absent.push_back(make(rng()));
+    }
+
+    std::printf("%s keys\n", type);
+    run<eden::flat_hash_map<Key, std::uint64_t>>("eden::flat_hash_map",
+                                                 present, absent);
+    run<std::unordered_map<Key, std::uint64_t>>("std::unordered_map",
+                                                present, absent);
+  }
+}
+
+} // namespace
+
+int main() {
+  suite<std::uint64_t>("uint64_t", [](std::uint64_t x) { return x; });
+  // long enough to be heap allocated, so a compare is a pointer chase too
+  suite<std::string>("std::string", [](std::uint64_t x) {
+    return "key-" + std::to_string(x) + "-padding-padding";
+  });
+}
@@ -0,0 +1,118 @@
+// Startup time: rebuilding a lookup vector and bitset from source data
+// against opening them with MappedVector and MappedBitset.
+//
+//   g++ -std=c++23 -O2 bench/mapped_storage_bench.cpp -o mapped_bench
+//   ./mapped_bench [directory]
+//
+// Files go to the temporary directory unless one is given. The mapped timings
+// are with the files in the page cache, as after a process restart; drop the
+// caches between runs to see a cold start.
+#include "../mapped_storage.hpp"
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Record {
+  std::uint64_t m_id;
+  double m_score;
+};
+
+constexpr std::size_t records = std::size_t{1} << 22;
+constexpr std::size_t flag_bits = std::size_t{1} << 24;
+
+double since_ms(std::chrono::steady_clock::time_point start) {
+  const std::chrono::duration<double, std::milli> took =
+      std::chrono::steady_clock::now() - start;
+  return took.count();
+}
+
+// the source data: one "id score" line per record
+void write_source(const std::filesystem::path &path) {
+  std::ofstream out(path);
+  for (std::size_t i = 0; i < records; ++i)
+    out << i * 2654435761u % (1u << 31) << ' ' << i * 0.25 << '\n';
+}
+
+double checksum(const Record *data, std::size_t n) {
+  double total = 0;
+  for (std::size_t i = 0; i < n; ++i)
+    total += static_cast<double>(data[i].m_id) + data[i].m_score;
+  return total;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const std::filesystem::path dir =
+      argc > 1 ? std::filesystem::path(argv[1])
+               : std::filesystem::temp_directory_path();
+  const auto source = dir / "eden_bench_source.txt";
+  const auto vector_file = dir / "eden_bench_vector.bin";
+  const auto bitset_file = dir / "eden_bench_bitset.bin";
+  write_source(source);
+
+  // what a restart costs today: parse the source, build vector and bitset
+  auto start = std::chrono::steady_clock::now();
+  std::vector<Record> rebuilt;
+  const auto flags = std::make_unique<edenlib::Bitset<flag_bits>>();
+  {
+    std::ifstream in(source);
+    std::string line;
+    while (std::getline(in, line)) {
+      Record record{};
+      const char *const end = line.data() + line.size();
+      const auto [next, ec] = std::from_chars(line.data(), end, record.m_id);
+      std::from_chars(next + 1, end, record.m_score);
+      rebuilt.push_back(record);
+      flags->set(record.m_id % flag_bits);
+    }
+  }
+  const double rebuild_ms = since_ms(start);
+  const double expected = checksum(rebuilt.data(), rebuilt.size());
+
+  // one-off cost of writing the mapped files
+  start = std::chrono::steady_clock::now();
+  {
+    eden::MappedVector<Record> vector(vector_file, eden::mapped_mode::create,
+                                      1, records);
+    for (const Record &record : rebuilt)
+      vector.push_back(record);
+    eden::MappedBitset<flag_bits> bitset(bitset_file,
+                                         eden::mapped_mode::create, 1);
+    bitset.bits() = *flags;
+    vector.flush();
+    bitset.flush();
+  }
+  const double write_ms = since_ms(start);
+
+  // a restart with the files: open, then touch every element once
+  start = std::chrono::steady_clock::now();
+  const eden::MappedVectorView<Record> vector(vector_file, 1);
+  const eden::MappedBitsetView<flag_bits> bitset(bitset_file, 1);
+  const double open_ms = since_ms(start);
+  const double mapped = checksum(vector.data(), vector.size());
+  const bool same_flags = bitset.bits().count() == flags->count();
+  const double scan_ms = since_ms(start);
+
+  std::printf("%zu records (%zu MiB), %zu flag bits\n", records,
+              records * sizeof(Record) >> 20, flag_bits);
+  std::printf("rebuild from source  %8.1f ms\n", rebuild_ms);
+  std::printf("write mapped files   %8.1f ms (once)\n", write_ms);
+  std::printf("mapped open          %8.3f ms\n", open_ms);
+  std::printf("mapped open + scan   %8.1f ms\n", scan_ms);
+  std::printf("contents match: %s\n",
+              mapped == expected && same_flags ? "yes" : "NO");
+
+  std::filesystem::remove(source);
+  std::filesystem::remove(vector_file);
+  std::filesystem::remove(bitset_file);
+  return mapped == expected && same_flags ? 0 : 1;
+}
@@ -0,0 +1,74 @@
+// SmallFunction against std::function and std::move_only_function.
+//
+//   g++ -std=c++23 -O2 bench/small_function_bench.cpp -o sf_bench
+#include "../small_function.hpp"
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace {
+
+constexpr int count = 1 << 20;
+constexpr int rounds = 8;
+
+template <class F> double time_ns(F &&f) {
+  double best = 1e300;
+  for (int r = 0; r < rounds; ++r) {
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    const std::chrono::duration<double, std::nano> took =
+        std::chrono::steady_clock::now() - start;
+    best = std::min(best, took.count() / count);
+  }
+  return best;
+}
+
+volatile long sink;
+
+// three pointers of capture: too big for the small buffer of std::function
+// in libstdc++ and libc++, inside SmallFunction's default 4 pointers
+struct Capture {
+  long *m_a, *m_b, *m_c;
+  long operator()(long x) const noexcept { return *m_a + *m_b + *m_c + x; }
+};
+
+template <class Function> void run(const char *name) {
+  long a = 1, b = 2, c = 3;
+  std::vector<Function> functions;
+  functions.reserve(count);
+
+  const double build = time_ns([&] {
+    functions.clear();
+    for (int i = 0; i < count; ++i)
+      functions.emplace_back(Capture{&a, &b, &c});
+  });
+
+  const double call = time_ns([&] {
+    long total = 0;
+    for (auto &f : functions)
+      total += f(1);
+    sink = total;
+  });
+
+  const double move = time_ns([&] {
+    std::vector<Function> moved;
+    moved.reserve(count);
+    for (auto &f : functions)
+      moved.push_back(std::move(f));
+    functions.swap(moved);
+  });
+
+  std::printf("%-28s build %6.2f ns  call %5.2f ns  move %5.2f ns\n", name,
+              build, call, move);
+}
+
+} // namespace
+
+int main() {
+  run<std::function<long(long)>>("std::function");
+  run<std::move_only_function<long(long)>>("std::move_only_function");
+  run<eden::SmallFunction<long(long)>>("eden::SmallFunction");
+  run<eden::MoveOnlySmallFunction<long(long)>>("eden::MoveOnlySmallFunction");
+}
@@ -0,0 +1,78 @@
+#!/usr/bin/env bash
+# Front-end time and peak memory of eden traits and concepts with and
+# without the compiler builtins (EDEN_NO_BUILTIN_TRAITS). Use a compiler that
+# has the builtins, e.g. clang 17 or later; GCC 12 only has __is_same,
+# __is_class, __is_enum and __is_union of them. The headers need
+# static_assert(false) in templates (P2593), so GCC 13 or clang 17 at least.
+# Peak memory is the compiler's maximum resident set size, read through
+# python3 since /usr/bin/time is not always installed.
+#
+#   CXX=clang++ bench/trait_compile_bench.sh [checks] [runs]
+set -euo pipefail
+shopt -s inherit_errexit
+
+CXX=${CXX:-clang++}
+CHECKS=${1:-3000}
+RUNS=${2:-3}
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+builtins=(__is_same __is_class __is_enum __is_union __is_pointer __is_void
+          __is_array __is_const __is_volatile __is_reference __is_function
+          __is_integral __is_floating_point __is_arithmetic __is_scalar
+          __is_object __is_fundamental __is_member_pointer
+          __is_lvalue_reference __is_rvalue_reference __remove_const
+          __remove_volatile __remove_cv __remove_cvref __remove_reference_t)
+have=0
+for builtin in "${builtins[@]}"; do
+  if printf '#if __has_builtin(%s)\nyes\n#endif\n' "$builtin" |
+    "$CXX" -E -x c++ - 2>/dev/null | grep -q yes; then
+    have=$((have + 1))
+  fi
+done
+echo "$CXX has $have of ${#builtins[@]} builtins used by type_traits.hpp and concepts.hpp"
+
+# every check is on a distinct type so nothing is cached between them, both
+# modes give the same answers (test/concepts_test.cpp)
+{
+  echo '#include "concepts.hpp"'
+  echo 'template <int N> struct tag {};'
+  for ((i = 0; i < CHECKS; ++i)); do
+    echo "constexpr bool check$i ="
+    echo "    eden::pointer_c<tag<$i> *> && eden::void_c<tag<$i>> &&"
+    echo "    eden::class_c<tag<$i>> && eden::arithmetic_c<tag<$i>> &&"
+    echo "    eden::same_c<eden::remove_cvref<const tag<$i> &>, tag<$i>>;"
+  done
+  echo 'int main() {}'
+} >"$WORK/traits.cpp"
+
+# prints the seconds and the peak resident KiB of one compiler run
+run_once() {
+  python3 -c '
+import resource, subprocess, sys, time
+start = time.perf_counter()
+subprocess.run(sys.argv[1:], check=True)
+seconds = time.perf_counter() - start
+peak = resource.getrusage(resource.RUSAGE_CHILDREN).ru_maxrss
+print(f"{seconds:.3f} {peak}")' "$@"
+}
+
+# lowest time and lowest peak over the runs
+measure() {
+  local results=
+  for ((run = 0; run < RUNS; ++run)); do
+    results+=$(run_once "$CXX" -std=c++23 -fsyntax-only -I"$ROOT" "$@" \
+      "$WORK/traits.cpp")$'\n'
+  done
+  printf '%s' "$results" | awk '
+    NR == 1 || $1 < time { time = $1 }
+    NR == 1 || $2 < peak { peak = $2 }
+    END { printf "%.3f s, %d KiB peak\n", time, peak }'
+}
+
+echo "$CHECKS checks, best of $RUNS"
+builtin_result=$(measure)
+portable_result=$(measure -DEDEN_NO_BUILTIN_TRAITS)
+echo "builtins:  $builtin_result"
+echo "portable:  $portable_result"
@@ -0,0 +1,559 @@
+#pragma once
+#include "bitset.hpp"
+#include "memory.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+namespace eden {
+
+/* Word kernels shared by BitMatrix and DynamicBitMatrix. A matrix is anything
+ * with rows(), cols(), words_per_row() and row_data(r); bit c of row r is bit
+ * c % 64 of row_data(r)[c / 64], the same layout as edenlib::Bitset.
+ * Bits past cols() in the last word of a row are padding. Kernels never read
+ * them as matrix entries and clear them in the rows they write.
+ */
+namespace bit_matrix_detail {
+using word = unsigned long long;
+static_assert(sizeof(word) * CHAR_BIT == 64);
+
+inline constexpr std::size_t word_bits = 64;
+
+constexpr std::size_t words_for(std::size_t bits) noexcept {
+  return (bits + word_bits - 1) / word_bits;
+}
+
+// mask of the bits of the last word of a row that are matrix entries
+constexpr word tail_mask(std::size_t cols) noexcept {
+  return cols % word_bits ? (word{1} << (cols % word_bits)) - 1 : ~word{};
+}
+
+/* In place transpose of a 64x64 block, bit j of a[i] swaps with bit i of
+ * a[j]. Six rounds swap ever smaller off-diagonal sub-blocks: 32x32, then
+ * 16x16 and so on, each one a shift, xor and mask over pairs of words.
+ */
+constexpr void transpose64(word *a) noexcept {
+  word mask = 0x00000000ffffffffull;
+  for (std::size_t j = 32; j != 0; j >>= 1, mask ^= mask << j) {
+    for (std::size_t k = 0; k < 64; k = ((k | j) + 1) & ~j) {
+      const word t = ((a[k] >> j) ^ a[k | j]) & mask;
+      a[k] ^= t << j;
+      a[k | j] ^= t;
+    }
+  }
+}
+
+template <class Matrix> void clear_padding(Matrix &m) noexcept {
+  if (m.words_per_row() == 0)
+    return;
+
+  const word mask = tail_mask(m.cols());
+  for (std::size_t r{}; r < m.rows(); ++r)
+    m.row_data(r)[words_for(m.cols()) - 1] &= mask;
+}
+
+// dst |= src over n words, simple enough for the compiler to vectorise.
+// dst and src must not overlap.
+inline void or_words(word *__restrict dst, const word *__restrict src,
+                     std::size_t n) noexcept {
+  for (std::size_t i{}; i < n; ++i)
+    dst[i] |= src[i];
+}
+
+// dst must be src.cols() x src.rows(), every word of it is overwritten
+template <class Dst, class Src> void transpose(Dst &dst, const Src &src) {
+  alignas(cache_line_size) word block[64];
+
+  for (std::size_t rb{}; rb < src.rows(); rb += word_bits) {
+    const std::size_t height = std::min(word_bits, src.rows() - rb);
+
+    for (std::size_t cw{}; cw < words_for(src.cols()); ++cw) {
+      for (std::size_t i{}; i < height; ++i)
+        block[i] = src.row_data(rb + i)[cw];
+      for (std::size_t i = height; i < word_bits; ++i)
+        block[i] = 0;
+
+      transpose64(block);
+
+      const std::size_t width =
+          std::min(word_bits, src.cols() - cw * word_bits);
+      for (std::size_t j{}; j < width; ++j)
+        dst.row_data(cw * word_bits + j)[rb / word_bits] = block[j];
+    }
+  }
+}
+
+/* Boolean product c = a * b with the method of the Four Russians. For every
+ * 64 rows of b, eight tables hold the OR of each subset of 8 of those rows,
+ * so a row of c takes eight table lookups per word of a instead of 64 row
+ * ORs. Columns of b are handled in stripes of at most table_stripe_words
+ * words so the 8 x 256 table rows of a stripe stay within L2.
+ * c must be a.rows() x b.cols() and is overwritten.
+ */
+template <class C, class A, class B>
+void multiply(C &c, const A &a, const B &b) {
+  constexpr std::size_t table_stripe_words = 32;
+  constexpr std::size_t tables = 8;
+  constexpr std::size_t table_rows = 256;
+
+  for (std::size_t r{}; r < c.rows(); ++r)
+    std::memset(c.row_data(r), 0, c.words_per_row() * sizeof(word));
+
+  const std::size_t inner = a.cols();
+  const std::size_t c_words = words_for(b.cols());
+  if (inner == 0 || c_words == 0)
+    return;
+
+  const std::size_t stripe_max = std::min(c_words, table_stripe_words);
+  const auto table = std::make_unique_for_overwrite<word[]>(
+      tables * table_rows * stripe_max);
+
+  for (std::size_t w0{}; w0 < c_words; w0 += stripe_max) {
+    const std::size_t stripe = std::min(stripe_max, c_words - w0);
+
+    for (std::size_t kw{}; kw < words_for(inner); ++kw) {
+      // table t, entry v is the OR of rows kw * 64 + 8 * t + bit of v of b
+      for (std::size_t t{}; t < tables; ++t) {
+        word *const base = table.get() + t * table_rows * stripe;
+        std::memset(base, 0, stripe * sizeof(word));
+
+        for (std::size_t v = 1; v < table_rows; ++v) {
+          word *const entry = base + v * stripe;
+          const std::size_t low = v & (0 - v);
+          std::memcpy(entry, base + (v ^ low) * stripe, stripe * sizeof(word));
+
+          const std::size_t k =
+              kw * word_bits + t * 8 + std::countr_zero(low);
+          if (k < inner)
+            or_words(entry, b.row_data(k) + w0, stripe);
+        }
+      }
+
+      const word mask =
+          kw + 1 == words_for(inner) ? tail_mask(inner) : ~word{};
+      for (std::size_t r{}; r < a.rows(); ++r) {
+        const word bits = a.row_data(r)[kw] & mask;
+        if (!bits)
+          continue;
+
+        word *const out = c.row_data(r) + w0;
+        for (std::size_t t{}; t < tables; ++t) {
+          const std::size_t v = (bits >> (t * 8)) & 0xff;
+          if (v)
+            or_words(out, table.get() + (t * table_rows + v) * stripe, stripe);
+        }
+      }
+    }
+  }
+
+  clear_padding(c);
+}
+
+/* Warshall's algorithm with the inner loop over whole rows: once every path
+ * through 0..k-1 is known, any row that reaches k also reaches all of row k.
+ * m must be square.
+ */
+template <class Matrix> void transitive_closure(Matrix &m) noexcept {
+  const std::size_t n = m.rows();
+  const std::size_t words = words_for(m.cols());
+
+  for (std::size_t k{}; k < n; ++k) {
+    const word *const through = m.row_data(k);
+    const std::size_t kw = k / word_bits;
+    const word kbit = word{1} << (k % word_bits);
+
+    for (std::size_t r{}; r < n; ++r) {
+      word *const row = m.row_data(r);
+      // row k | row k is row k, and or_words must not alias
+      if (r != k && (row[kw] & kbit))
+        or_words(row, through, words);
+    }
+  }
+}
+
+template <class Matrix> std::size_t count(const Matrix &m) noexcept {
+  std::size_t total{};
+  if (m.words_per_row() == 0)
+    return total;
+
+  const std::size_t last = words_for(m.cols()) - 1;
+  for (std::size_t r{}; r < m.rows(); ++r) {
+    const word *const row = m.row_data(r);
+    for (std::size_t w{}; w < last; ++w)
+      total += std::popcount(row[w]);
+    total += std::popcount(row[last] & tail_mask(m.cols()));
+  }
+
+  return total;
+}
+} // namespace bit_matrix_detail
+
+/* R x C boolean matrix stored as R edenlib::Bitset<C> rows, so a row can be
+ * handed to code that already works on Bitset. The rows are contiguous and
+ * the whole block starts on a cache line.
+ *
+ * To Do:
+ *  Pad rows to whole cache lines when C is large
+ */
+template <std::size_t R, std::size_t C> class BitMatrix {
+public:
+  using row_type = edenlib::Bitset<C>;
+  using data_type = typename row_type::data_type;
+
+private:
+  alignas(cache_line_size) row_type m_rows[R];
+
+  static constexpr void check(std::size_t r, std::size_t c) {
+    if (r >= R || c >= C)
+      throw std::runtime_error("Invalid position for BitMatrix");
+  }
+
+public:
+  /* Special Member Functions */
+  constexpr BitMatrix() noexcept = default;
+  constexpr BitMatrix(const BitMatrix &other) noexcept = default;
+  constexpr BitMatrix &operator=(const BitMatrix &other) noexcept = default;
+  /* Special Member Functions */
+
+  /* Element Access */
+  [[nodiscard]] constexpr bool test(std::size_t r, std::size_t c) const {
+    check(r, c);
+    return m_rows[r].test(c);
+  }
+
+  constexpr BitMatrix &set(std::size_t r, std::size_t c, bool value = true) {
+    check(r, c);
+    m_rows[r].set(c, value);
+    return *this;
+  }
+
+  constexpr row_type &row(std::size_t r) {
+    if (r >= R)
+      throw std::runtime_error("Invalid row for BitMatrix");
+    return m_rows[r];
+  }
+
+  constexpr const row_type &row(std::size_t r) const {
+    if (r >= R)
+      throw std::runtime_error("Invalid row for BitMatrix");
+    return m_rows[r];
+  }
+
+  constexpr row_type &operator[](std::size_t r) noexcept { return m_rows[r]; }
+  constexpr const row_type &operator[](std::size_t r) const noexcept {
+    return m_rows[r];
+  }
+
+  [[nodiscard]] data_type *row_data(std::size_t r) noexcept {
+    return m_rows[r].bits;
+  }
+  [[nodiscard]] const data_type *row_data(std::size_t r) const noexcept {
+    return m_rows[r].bits;
+  }
+
+  // copy of column c, built from 64x64 block transposes
+  [[nodiscard]] edenlib::Bitset<R> column(std::size_t c) const {
+    if (c >= C)
+      throw std::runtime_error("Invalid column for BitMatrix");
+
+    edenlib::Bitset<R> ret_val;
+    alignas(cache_line_size) data_type block[64];
+    const std::size_t cw = c / 64;
+
+    for (std::size_t rb{}; rb < R; rb += 64) {
+      const std::size_t height = std::min<std::size_t>(64, R - rb);
+      for (std::size_t i{}; i < height; ++i)
+        block[i] = m_rows[rb + i].bits[cw];
+      for (std::size_t i = height; i < 64; ++i)
+        block[i] = 0;
+
+      bit_matrix_detail::transpose64(block);
+      ret_val.bits[rb / 64] = block[c % 64];
+    }
+
+    return ret_val;
+  }
+  /* Element Access */
+
+  /* Capacity */
+  [[nodiscard]] static constexpr std::size_t rows() noexcept { return R; }
+  [[nodiscard]] static constexpr std::size_t cols() noexcept { return C; }
+  [[nodiscard]] static constexpr std::size_t words_per_row() noexcept {
+    return row_type::num_data;
+  }
+  [[nodiscard]] std::size_t count() const noexcept {
+    return bit_matrix_detail::count(*this);
+  }
+  /* Capacity */
+
+  /* Operations */
+  // row dst |= row src
+  BitMatrix &row_or_accumulate(std::size_t dst, std::size_t src) {
+    if (dst >= R || src >= R)
+      throw std::runtime_error("Invalid row for BitMatrix");
+    if (dst == src)
+      return *this;
+
+    bit_matrix_detail::or_words(m_rows[dst].bits, m_rows[src].bits,
+                                words_per_row());
+    return *this;
+  }
+
+  BitMatrix &row_or_accumulate(std::size_t dst, const row_type &other) {
+    if (dst >= R)
+      throw std::runtime_error("Invalid row for BitMatrix");
+    if (&other == &m_rows[dst])
+      return *this;
+
+    bit_matrix_detail::or_words(m_rows[dst].bits, other.bits,
+                                words_per_row());
+    return *this;
+  }
+
+  [[nodiscard]] BitMatrix<C, R> transpose() const {
+    BitMatrix<C, R> ret_val;
+    bit_matrix_detail::transpose(ret_val, *this);
+    return ret_val;
+  }
+
+  // in place, afterwards test(i, j) is whether j is reachable from i
+  BitMatrix &transitive_closure() noexcept
+    requires(R == C)
+  {
+    bit_matrix_detail::transitive_closure(*this);
+    bit_matrix_detail::clear_padding(*this);
+    return *this;
+  }
+  /* Operations */
+};
+
+template <std::size_t R, std::size_t K, std::size_t C>
+BitMatrix<R, C> operator*(const BitMatrix<R, K> &lhs,
+                          const BitMatrix<K, C> &rhs) {
+  BitMatrix<R, C> ret_val;
+  bit_matrix_detail::multiply(ret_val, lhs, rhs);
+  return ret_val;
+}
+
+/* Boolean matrix with its size chosen at run time. Rows of at least half a
+ * cache line are padded to whole cache lines and the block is cache line
+ * aligned, so no row straddles more lines than it has to.
+ */
+template <class Allocator = allocator<bit_matrix_detail::word>>
+class DynamicBitMatrix {
+public:
+  using data_type = bit_matrix_detail::word;
+
+private:
+  static constexpr std::size_t line_words =
+      cache_line_size / sizeof(data_type);
+
+  [[no_unique_address]] Allocator m_alloc;
+  std::size_t m_rows{0};
+  std::size_t m_cols{0};
+  std::size_t m_stride{0};
+  data_type *m_block{nullptr}; // as returned by the allocator
+  data_type *m_data{nullptr};  // m_block rounded up to a cache line
+
+  static constexpr std::size_t stride_for(std::size_t cols) noexcept {
+    const std::size_t words = bit_matrix_detail::words_for(cols);
+    if (words < line_words / 2)
+      return words;
+    return (words + line_words - 1) / line_words * line_words;
+  }
+
+  [[nodiscard]] std::size_t block_words() const noexcept {
+    return m_block ? m_rows * m_stride + line_words : 0;
+  }
+
+  void allocate() {
+    if (m_rows * m_stride == 0)
+      return;
+
+    m_block = m_alloc.allocate(m_rows * m_stride + line_words);
+    if (!m_block)
+      throw std::bad_alloc();
+
+    const auto address = reinterpret_cast<std::uintptr_t>(m_block);
+    const std::size_t skip =
+        (cache_line_size - address % cache_line_size) % cache_line_size;
+    m_data = m_block + skip / sizeof(data_type);
+    std::memset(m_data, 0, m_rows * m_stride * sizeof(data_type));
+  }
+
+  void release() noexcept {
+    if (m_block)
+      m_alloc.deallocate(m_block, block_words());
+    m_block = nullptr;
+    m_data = nullptr;
+  }
+
+  void check(std::size_t r, std::size_t c) const {
+    if (r >= m_rows || c >= m_cols)
+      throw std::runtime_error("Invalid position for DynamicBitMatrix");
+  }
+
+public:
+  /* Special Member Functions */
+  DynamicBitMatrix() noexcept(noexcept(Allocator())) = default;
+
+  DynamicBitMatrix(std::size_t rows, std::size_t cols,
+                   const Allocator &alloc = Allocator())
+      : m_alloc(alloc), m_rows(rows), m_cols(cols), m_stride(stride_for(cols)) {
+    allocate();
+  }
+
+  DynamicBitMatrix(const DynamicBitMatrix &other)
+      : m_alloc(other.m_alloc), m_rows(other.m_rows), m_cols(other.m_cols),
+        m_stride(other.m_stride) {
+    allocate();
+    if (m_data)
+      std::memcpy(m_data, other.m_data, m_rows * m_stride * sizeof(data_type));
+  }
+
+  DynamicBitMatrix(DynamicBitMatrix &&other) noexcept
+      : m_alloc(std::move(other.m_alloc)),
+        m_rows(std::exchange(other.m_rows, 0)),
+        m_cols(std::exchange(other.m_cols, 0)),
+        m_stride(std::exchange(other.m_stride, 0)),
+        m_block(std::exchange(other.m_block, nullptr)),
+        m_data(std::exchange(other.m_data, nullptr)) {}
+
+  DynamicBitMatrix &operator=(const DynamicBitMatrix &other) {
+    if (this != &other) {
+      DynamicBitMatrix copy(other);
+      *this = std::move(copy);
+    }
+    return *this;
+  }
+
+  DynamicBitMatrix &operator=(DynamicBitMatrix &&other) noexcept {
+    if (this != &other) {
+      release();
+      m_alloc = std::move(other.m_alloc);
+      m_rows = std::exchange(other.m_rows, 0);
+      m_cols = std::exchange(other.m_cols, 0);
+      m_stride = std::exchange(other.m_stride, 0);
+      m_block = std::exchange(other.m_block, nullptr);
+      m_data = std::exchange(other.m_data, nullptr);
+    }
+    return *this;
+  }
+
+  ~DynamicBitMatrix() noexcept { release(); }
+  /* Special Member Functions */
+
+  /* Element Access */
+  [[nodiscard]] bool test(std::size_t r, std::size_t c) const {
+    check(r, c);
+    return row_data(r)[c / 64] >> (c % 64) & 1;
+  }
+
+  DynamicBitMatrix &set(std::size_t r, std::size_t c, bool value = true) {
+    check(r, c);
+    const data_type mask = data_type{1} << (c % 64);
+    if (value)
+      row_data(r)[c / 64] |= mask;
+    else
+      row_data(r)[c / 64] &= ~mask;
+
+    return *this;
+  }
+
+  [[nodiscard]] data_type *row_data(std::size_t r) noexcept {
+    return m_data + r * m_stride;
+  }
+  [[nodiscard]] const data_type *row_data(std::size_t r) const noexcept {
+    return m_data + r * m_stride;
+  }
+
+  // copy of column c as a 1 x rows() matrix
+  [[nodiscard]] DynamicBitMatrix column(std::size_t c) const {
+    if (c >= m_cols)
+      throw std::runtime_error("Invalid column for DynamicBitMatrix");
+
+    DynamicBitMatrix ret_val(1, m_rows, m_alloc);
+    alignas(cache_line_size) data_type block[64];
+    const std::size_t cw = c / 64;
+
+    for (std::size_t rb{}; rb < m_rows; rb += 64) {
+      const std::size_t height = std::min<std::size_t>(64, m_rows - rb);
+      for (std::size_t i{}; i < height; ++i)
+        block[i] = row_data(rb + i)[cw];
+      for (std::size_t i = height; i < 64; ++i)
+        block[i] = 0;
+
+      bit_matrix_detail::transpose64(block);
+      ret_val.row_data(0)[rb / 64] = block[c % 64];
+    }
+
+    return ret_val;
+  }
+  /* Element Access */
+
+  /* Capacity */
+  [[nodiscard]] bool is_empty() const noexcept {
+    return m_rows == 0 || m_cols == 0;
+  }
+  [[nodiscard]] std::size_t rows() const noexcept { return m_rows; }
+  [[nodiscard]] std::size_t cols() const noexcept { return m_cols; }
+  [[nodiscard]] std::size_t words_per_row() const noexcept { return m_stride; }
+  [[nodiscard]] std::size_t count() const noexcept {
+    return bit_matrix_detail::count(*this);
+  }
+  /* Capacity */
+
+  /* Modifiers */
+  void clear() noexcept {
+    if (m_data)
+      std::memset(m_data, 0, m_rows * m_stride * sizeof(data_type));
+  }
+  /* Modifiers */
+
+  /* Operations */
+  // row dst |= row src
+  DynamicBitMatrix &row_or_accumulate(std::size_t dst, std::size_t src) {
+    if (dst >= m_rows || src >= m_rows)
+      throw std::runtime_error("Invalid row for DynamicBitMatrix");
+    if (dst == src)
+      return *this;
+
+    bit_matrix_detail::or_words(row_data(dst), row_data(src),
+                                bit_matrix_detail::words_for(m_cols));
+    return *this;
+  }
+
+  [[nodiscard]] DynamicBitMatrix transpose() const {
+    DynamicBitMatrix ret_val(m_cols, m_rows, m_alloc);
+    bit_matrix_detail::transpose(ret_val, *this);
+    return ret_val;
+  }
+
+  // in place, afterwards test(i, j) is whether j is reachable from i
+  DynamicBitMatrix &transitive_closure() {
+    if (m_rows != m_cols)
+      throw std::runtime_error("transitive_closure needs a square matrix");
+
+    bit_matrix_detail::transitive_closure(*this);
+    bit_matrix_detail::clear_padding(*this);
+    return *this;
+  }
+  /* Operations */
+
+  friend DynamicBitMatrix operator*(const DynamicBitMatrix &lhs,
+                                    const DynamicBitMatrix &rhs) {
+    if (lhs.m_cols != rhs.m_rows)
+      throw std::runtime_error("BitMatrix product of mismatched sizes");
+
+    DynamicBitMatrix ret_val(lhs.m_rows, rhs.m_cols, lhs.m_alloc);
+    bit_matrix_detail::multiply(ret_val, lhs, rhs);
+    return ret_val;
+  }
+};
+
+} // namespace eden
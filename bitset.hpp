@@ -1,3 +1,5 @@
+#pragma once
+#include <climits>
 #include <cstddef>
 #include <limits>
 #include <stdexcept>
@@ -45,15 +47,16 @@ template <size_t N> struct Bitset {
   using data_type = unsigned long long;
 
   static constexpr size_t sizeofType = sizeof(data_type);
-  static constexpr size_t num_data = (N - 1) / sizeofType + 1;
+  static constexpr size_t bitsofType = sizeofType * CHAR_BIT;
+  static constexpr size_t num_data = (N - 1) / bitsofType + 1;
   static constexpr data_type maxofType = std::numeric_limits<data_type>::max();
   static constexpr size_t indexOf(size_t pos) noexcept {
-    return pos / sizeofType;
+    return pos / bitsofType;
   }
   static constexpr size_t size() noexcept { return N; }
 
   static constexpr data_type maskFor(size_t pos) noexcept {
-    return 1ull << (pos % sizeofType);
+    return 1ull << (pos % bitsofType);
   }
 
   constexpr bool operator[](size_t pos) const { return test(pos); }
@@ -106,17 +109,23 @@ template <size_t N> struct Bitset {
       <>(const Bitset &lhs, const Bitset &rhs) noexcept;
 
   constexpr Bitset &operator&=(const Bitset &other) noexcept {
-    *this = *this & other;
+    for (auto i{0uz}; i < num_data; ++i)
+      bits[i] &= other.bits[i];
+
     return *this;
   }
 
   constexpr Bitset &operator|=(const Bitset &other) noexcept {
-    *this = *this | other;
+    for (auto i{0uz}; i < num_data; ++i)
+      bits[i] |= other.bits[i];
+
     return *this;
   }
 
   constexpr Bitset &operator^=(const Bitset &other) noexcept {
-    *this = *this ^ other;
+    for (auto i{0uz}; i < num_data; ++i)
+      bits[i] ^= other.bits[i];
+
     return *this;
   }
 
@@ -184,8 +193,10 @@ template <size_t N> struct Bitset {
 
   constexpr Bitset(const Bitset &other) {
     for (auto i{0uz}; i < num_data; ++i)
-      bits[i] = other.bits[num_data];
+      bits[i] = other.bits[i];
   }
+
+  constexpr Bitset &operator=(const Bitset &other) noexcept = default;
 };
 
 } // namespace edenlib
@@ -0,0 +1,546 @@
+#pragma once
+#include "bitset.hpp"
+#include "memory.hpp"
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+namespace eden {
+
+/* Default hash for the filters below. Integers, enums and pointers go
+ * through a single 64-bit finalizer, strings and other trivially copyable
+ * keys are folded eight bytes at a time.
+ */
+struct bloom_hash {
+  static constexpr std::uint64_t mix(std::uint64_t x) noexcept {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return x;
+  }
+
+  static std::uint64_t bytes(const void *data, std::size_t len) noexcept {
+    const auto *ptr = static_cast<const unsigned char *>(data);
+    std::uint64_t h = 0x9e3779b97f4a7c15ull ^ len;
+
+    for (; len >= 8; len -= 8, ptr += 8) {
+      std::uint64_t word;
+      std::memcpy(&word, ptr, 8);
+      h = (h ^ mix(word)) * 0x100000001b3ull;
+    }
+
+    std::uint64_t tail{};
+    std::memcpy(&tail, ptr, len);
+    return mix(h ^ tail);
+  }
+
+  /* Every string form of a key, std::string, std::string_view, const char *
+   * and a string literal, hashes its characters up to the first NUL, so a
+   * key inserted in one form is found in any other.
+   */
+  static constexpr std::uint64_t text(std::string_view key) noexcept {
+    if !consteval {
+      return bytes(key.data(), key.size());
+    }
+
+    // same folding as bytes() on a little endian target
+    std::uint64_t h = 0x9e3779b97f4a7c15ull ^ key.size();
+    std::size_t i{};
+    for (; key.size() - i >= 8; i += 8) {
+      std::uint64_t word{};
+      for (std::size_t b{}; b < 8; ++b)
+        word |= std::uint64_t{static_cast<unsigned char>(key[i + b])}
+                << (8 * b);
+      h = (h ^ mix(word)) * 0x100000001b3ull;
+    }
+
+    std::uint64_t tail{};
+    for (std::size_t b{}; i + b < key.size(); ++b)
+      tail |= std::uint64_t{static_cast<unsigned char>(key[i + b])} << (8 * b);
+    return mix(h ^ tail);
+  }
+
+  template <class Key>
+    requires std::is_integral_v<Key> || std::is_enum_v<Key>
+  constexpr std::uint64_t operator()(Key key) const noexcept {
+    return mix(static_cast<std::uint64_t>(key));
+  }
+
+  // by address, character pointers are strings and go to the overloads below
+  template <class T>
+    requires(!std::is_same_v<std::remove_cv_t<T>, char>)
+  std::uint64_t operator()(T *key) const noexcept {
+    return mix(reinterpret_cast<std::uintptr_t>(key));
+  }
+
+  constexpr std::uint64_t operator()(std::string_view key) const noexcept {
+    return text(key);
+  }
+
+  constexpr std::uint64_t operator()(const std::string &key) const noexcept {
+    return text(key);
+  }
+
+  constexpr std::uint64_t operator()(const char *key) const noexcept {
+    return text(key);
+  }
+
+  // arrays and pointers are never hashed as raw bytes, char arrays decay to
+  // const char *
+  template <class Key>
+    requires(!std::is_integral_v<Key> && !std::is_enum_v<Key> &&
+             !std::is_array_v<Key> && !std::is_pointer_v<Key> &&
+             std::has_unique_object_representations_v<Key>)
+  std::uint64_t operator()(const Key &key) const noexcept {
+    return bytes(&key, sizeof(Key));
+  }
+};
+
+static_assert(bloom_hash{}("bloom filter key") ==
+                  bloom_hash{}(std::string_view("bloom filter key")) &&
+              bloom_hash{}(std::string("bloom filter key")) ==
+                  bloom_hash{}(std::string_view("bloom filter key")) &&
+              bloom_hash{}(static_cast<const char *>("key")) ==
+                  bloom_hash{}(std::string("key")),
+              "every string form of a key must hash the same");
+
+inline void bloom_prefetch(const void *addr) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_prefetch(addr);
+#else
+  (void)addr;
+#endif
+}
+
+/* Cache-line blocked Bloom filter over an edenlib::Bitset. The first hash
+ * picks one 512-bit block, all NumHashes probes land inside it, so a lookup
+ * touches a single cache line.
+ *
+ * Bits is rounded up to a whole number of blocks. There is no dynamically
+ * sized Bitset, so the size is fixed at compile time and the bits are stored
+ * inline; put large filters on the heap.
+ */
+template <std::size_t Bits, std::size_t NumHashes = 8, class Hash = bloom_hash>
+class BloomFilter {
+public:
+  static constexpr std::size_t block_bits = cache_line_size * 8;
+  static constexpr std::size_t num_blocks = (Bits - 1) / block_bits + 1;
+  using bitset_type = edenlib::Bitset<num_blocks * block_bits>;
+  using word_type = bitset_type::data_type;
+
+private:
+  static_assert(NumHashes > 0 && NumHashes <= 16);
+  static constexpr std::size_t words_per_block =
+      block_bits / bitset_type::bitsofType;
+  // contains_n looks this many keys ahead when prefetching blocks
+  static constexpr std::size_t batch_size = 16;
+
+  alignas(cache_line_size) bitset_type m_bits;
+  [[no_unique_address]] Hash m_hash;
+
+  struct probe {
+    std::size_t m_block;
+    std::uint64_t m_hash;
+  };
+
+  static constexpr probe probe_for(std::uint64_t hash) noexcept {
+    // multiply-shift range reduction, avoids a modulo by num_blocks
+    const std::size_t block =
+        static_cast<std::size_t>(((hash >> 32) * num_blocks) >> 32);
+    return {block, hash};
+  }
+
+  // masks for each word of the block, built in registers
+  static constexpr std::array<word_type, words_per_block>
+  block_masks(std::uint64_t hash) noexcept {
+    std::array<word_type, words_per_block> masks{};
+    const std::uint32_t first = static_cast<std::uint32_t>(hash);
+    const std::uint32_t step =
+        static_cast<std::uint32_t>(bloom_hash::mix(hash) >> 32) | 1;
+
+    for (std::size_t i{}; i < NumHashes; ++i) {
+      const std::uint32_t bit = (first + i * step) % block_bits;
+      masks[bit / bitset_type::bitsofType] |=
+          word_type{1} << (bit % bitset_type::bitsofType);
+    }
+
+    return masks;
+  }
+
+  const word_type *block_data(std::size_t block) const noexcept {
+    return m_bits.bits + block * words_per_block;
+  }
+
+  bool test_probe(const probe &p) const noexcept {
+    const auto masks = block_masks(p.m_hash);
+    const word_type *const words = block_data(p.m_block);
+
+    word_type missing{};
+    for (std::size_t w{}; w < words_per_block; ++w)
+      missing |= masks[w] & ~words[w];
+
+    return missing == 0;
+  }
+
+public:
+  /* Special Member Functions */
+  constexpr BloomFilter() noexcept = default;
+  explicit constexpr BloomFilter(const Hash &hash) noexcept : m_hash(hash) {}
+  /* Special Member Functions */
+
+  /* Modifiers */
+  template <class Key> void insert(const Key &key) noexcept {
+    const probe p = probe_for(m_hash(key));
+    const auto masks = block_masks(p.m_hash);
+    word_type *const words = m_bits.bits + p.m_block * words_per_block;
+
+    for (std::size_t w{}; w < words_per_block; ++w)
+      words[w] |= masks[w];
+  }
+
+  constexpr void clear() noexcept {
+    for (auto &word : m_bits.bits)
+      word = 0;
+  }
+
+  BloomFilter &operator|=(const BloomFilter &other) noexcept {
+    m_bits |= other.m_bits;
+    return *this;
+  }
+
+  BloomFilter &operator&=(const BloomFilter &other) noexcept {
+    m_bits &= other.m_bits;
+    return *this;
+  }
+
+  // union, contains everything either filter contains
+  friend BloomFilter operator|(const BloomFilter &lhs,
+                               const BloomFilter &rhs) noexcept {
+    BloomFilter ret_val(lhs);
+    ret_val |= rhs;
+    return ret_val;
+  }
+
+  // intersection, may report more false positives than a filter built from
+  // the common keys alone
+  friend BloomFilter operator&(const BloomFilter &lhs,
+                               const BloomFilter &rhs) noexcept {
+    BloomFilter ret_val(lhs);
+    ret_val &= rhs;
+    return ret_val;
+  }
+  /* Modifiers */
+
+  /* Lookup */
+  template <class Key>
+  [[nodiscard]] bool contains(const Key &key) const noexcept {
+    return test_probe(probe_for(m_hash(key)));
+  }
+
+  /* Writes contains(keys[i]) to out[i]. Hashes a batch first and prefetches
+   * every block, so the cache misses of the batch overlap instead of being
+   * paid one after the other.
+   */
+  template <class Key>
+  void contains_n(const Key *keys, std::size_t n, bool *out) const noexcept {
+    probe probes[batch_size];
+
+    for (std::size_t first{}; first < n; first += batch_size) {
+      const std::size_t count = std::min(batch_size, n - first);
+
+      for (std::size_t i{}; i < count; ++i) {
+        probes[i] = probe_for(m_hash(keys[first + i]));
+        bloom_prefetch(block_data(probes[i].m_block));
+      }
+
+      for (std::size_t i{}; i < count; ++i)
+        out[first + i] = test_probe(probes[i]);
+    }
+  }
+  /* Lookup */
+
+  /* Capacity */
+  static constexpr std::size_t size() noexcept {
+    return num_blocks * block_bits;
+  }
+
+  [[nodiscard]] std::size_t count() const noexcept {
+    std::size_t num_set{};
+    for (const word_type word : m_bits.bits)
+      num_set += std::popcount(word);
+
+    return num_set;
+  }
+
+  // (fraction of bits set) ^ NumHashes, ignores the skew from blocking
+  [[nodiscard]] double estimated_false_positive_rate() const noexcept {
+    const double fill = static_cast<double>(count()) / size();
+    double rate = 1.0;
+    for (std::size_t i{}; i < NumHashes; ++i)
+      rate *= fill;
+
+    return rate;
+  }
+
+  [[nodiscard]] const bitset_type &bits() const noexcept { return m_bits; }
+  /* Capacity */
+};
+
+/* Split block Bloom filter, as used by Parquet and Impala. Each 256-bit block
+ * is viewed as eight 32-bit lanes and every key sets exactly one bit per
+ * lane, so insert and lookup are a fixed sequence of word operations without
+ * data dependent loops. Compilers turn the lane loop into SIMD code where the
+ * target has it.
+ */
+template <std::size_t Bits, class Hash = bloom_hash>
+class SplitBlockBloomFilter {
+public:
+  static constexpr std::size_t block_bits = 256;
+  static constexpr std::size_t num_blocks = (Bits - 1) / block_bits + 1;
+  static constexpr std::size_t num_lanes = 8;
+  using bitset_type = edenlib::Bitset<num_blocks * block_bits>;
+  using word_type = bitset_type::data_type;
+
+private:
+  static constexpr std::size_t words_per_block =
+      block_bits / bitset_type::bitsofType;
+  static constexpr std::size_t batch_size = 16;
+
+  static constexpr std::uint32_t salts[num_lanes] = {
+      0x47b6137bu, 0x44974d91u, 0x8824ad5bu, 0xa2b7289du,
+      0x705495c7u, 0x2df1424bu, 0x9efc4947u, 0x5c6bfb31u};
+
+  alignas(cache_line_size) bitset_type m_bits;
+  [[no_unique_address]] Hash m_hash;
+
+  static constexpr std::size_t block_for(std::uint64_t hash) noexcept {
+    return static_cast<std::size_t>(((hash >> 32) * num_blocks) >> 32);
+  }
+
+  static constexpr std::array<word_type, words_per_block>
+  block_masks(std::uint64_t hash) noexcept {
+    const std::uint32_t key = static_cast<std::uint32_t>(hash);
+
+    std::array<std::uint32_t, num_lanes> lanes;
+    for (std::size_t i{}; i < num_lanes; ++i)
+      lanes[i] = std::uint32_t{1} << ((key * salts[i]) >> 27);
+
+    std::array<word_type, words_per_block> masks;
+    for (std::size_t w{}; w < words_per_block; ++w)
+      masks[w] = lanes[2 * w] | (word_type{lanes[2 * w + 1]} << 32);
+
+    return masks;
+  }
+
+  bool test_hash(std::uint64_t hash) const noexcept {
+    const auto masks = block_masks(hash);
+    const word_type *const words =
+        m_bits.bits + block_for(hash) * words_per_block;
+
+    word_type missing{};
+    for (std::size_t w{}; w < words_per_block; ++w)
+      missing |= masks[w] & ~words[w];
+
+    return missing == 0;
+  }
+
+public:
+  /* Special Member Functions */
+  constexpr SplitBlockBloomFilter() noexcept = default;
+  explicit constexpr SplitBlockBloomFilter(const Hash &hash) noexcept
+      : m_hash(hash) {}
+  /* Special Member Functions */
+
+  /* Modifiers */
+  template <class Key> void insert(const Key &key) noexcept {
+    const std::uint64_t hash = m_hash(key);
+    const auto masks = block_masks(hash);
+    word_type *const words = m_bits.bits + block_for(hash) * words_per_block;
+
+    for (std::size_t w{}; w < words_per_block; ++w)
+      words[w] |= masks[w];
+  }
+
+  constexpr void clear() noexcept {
+    for (auto &word : m_bits.bits)
+      word = 0;
+  }
+
+  SplitBlockBloomFilter &operator|=(const SplitBlockBloomFilter &other) noexcept {
+    m_bits |= other.m_bits;
+    return *this;
+  }
+
+  SplitBlockBloomFilter &operator&=(const SplitBlockBloomFilter &other) noexcept {
+    m_bits &= other.m_bits;
+    return *this;
+  }
+
+  friend SplitBlockBloomFilter
+  operator|(const SplitBlockBloomFilter &lhs,
+            const SplitBlockBloomFilter &rhs) noexcept {
+    SplitBlockBloomFilter ret_val(lhs);
+    ret_val |= rhs;
+    return ret_val;
+  }
+
+  friend SplitBlockBloomFilter
+  operator&(const SplitBlockBloomFilter &lhs,
+            const SplitBlockBloomFilter &rhs) noexcept {
+    SplitBlockBloomFilter ret_val(lhs);
+    ret_val &= rhs;
+    return ret_val;
+  }
+  /* Modifiers */
+
+  /* Lookup */
+  template <class Key>
+  [[nodiscard]] bool contains(const Key &key) const noexcept {
+    return test_hash(m_hash(key));
+  }
+
+  template <class Key>
+  void contains_n(const Key *keys, std::size_t n, bool *out) const noexcept {
+    std::uint64_t hashes[batch_size];
+
+    for (std::size_t first{}; first < n; first += batch_size) {
+      const std::size_t count = std::min(batch_size, n - first);
+
+      for (std::size_t i{}; i < count; ++i) {
+        hashes[i] = m_hash(keys[first + i]);
+        bloom_prefetch(m_bits.bits + block_for(hashes[i]) * words_per_block);
+      }
+
+      for (std::size_t i{}; i < count; ++i)
+        out[first + i] = test_hash(hashes[i]);
+    }
+  }
+  /* Lookup */
+
+  /* Capacity */
+  static constexpr std::size_t size() noexcept {
+    return num_blocks * block_bits;
+  }
+
+  [[nodiscard]] std::size_t count() const noexcept {
+    std::size_t num_set{};
+    for (const word_type word : m_bits.bits)
+      num_set += std::popcount(word);
+
+    return num_set;
+  }
+
+  // each lane behaves as its own one-hash filter over 32 bits
+  [[nodiscard]] double estimated_false_positive_rate() const noexcept {
+    const double fill = static_cast<double>(count()) / size();
+    double rate = 1.0;
+    for (std::size_t i{}; i < num_lanes; ++i)
+      rate *= fill;
+
+    return rate;
+  }
+
+  [[nodiscard]] const bitset_type &bits() const noexcept { return m_bits; }
+  /* Capacity */
+};
+
+/* Counting Bloom filter, supports erase. Counters are 4 bits wide and packed
+ * 128 to a cache line, with the same blocking as BloomFilter. A counter that
+ * reaches 15 sticks there, so erasing never produces a false negative.
+ */
+template <std::size_t Counters, std::size_t NumHashes = 8,
+          class Hash = bloom_hash>
+class CountingBloomFilter {
+public:
+  static constexpr std::size_t block_counters = cache_line_size * 2;
+  static constexpr std::size_t num_blocks =
+      (Counters - 1) / block_counters + 1;
+
+private:
+  static_assert(NumHashes > 0 && NumHashes <= 16);
+  static constexpr std::uint8_t max_count = 15;
+
+  alignas(cache_line_size) std::uint8_t m_nibbles[num_blocks * cache_line_size]{};
+  [[no_unique_address]] Hash m_hash;
+
+  static constexpr std::size_t block_for(std::uint64_t hash) noexcept {
+    return static_cast<std::size_t>(((hash >> 32) * num_blocks) >> 32);
+  }
+
+  // visits the NumHashes counter slots of hash, duplicates included
+  template <class Visitor>
+  static constexpr void for_each_slot(std::uint64_t hash, Visitor &&visit) {
+    const std::size_t base = block_for(hash) * block_counters;
+    const std::uint32_t first = static_cast<std::uint32_t>(hash);
+    const std::uint32_t step =
+        static_cast<std::uint32_t>(bloom_hash::mix(hash) >> 32) | 1;
+
+    for (std::size_t i{}; i < NumHashes; ++i)
+      visit(base + (first + i * step) % block_counters);
+  }
+
+  std::uint8_t get(std::size_t slot) const noexcept {
+    return (m_nibbles[slot / 2] >> ((slot % 2) * 4)) & 0xf;
+  }
+
+  void put(std::size_t slot, std::uint8_t value) noexcept {
+    const unsigned shift = (slot % 2) * 4;
+    m_nibbles[slot / 2] = static_cast<std::uint8_t>(
+        (m_nibbles[slot / 2] & ~(0xf << shift)) | (value << shift));
+  }
+
+public:
+  /* Special Member Functions */
+  constexpr CountingBloomFilter() noexcept = default;
+  explicit constexpr CountingBloomFilter(const Hash &hash) noexcept
+      : m_hash(hash) {}
+  /* Special Member Functions */
+
+  /* Modifiers */
+  template <class Key> void insert(const Key &key) noexcept {
+    for_each_slot(m_hash(key), [this](std::size_t slot) {
+      const std::uint8_t value = get(slot);
+      if (value != max_count)
+        put(slot, value + 1);
+    });
+  }
+
+  // only erase keys that were inserted, or the filter gains false negatives
+  template <class Key> void erase(const Key &key) noexcept {
+    for_each_slot(m_hash(key), [this](std::size_t slot) {
+      const std::uint8_t value = get(slot);
+      if (value != 0 && value != max_count)
+        put(slot, value - 1);
+    });
+  }
+
+  constexpr void clear() noexcept {
+    for (auto &byte : m_nibbles)
+      byte = 0;
+  }
+  /* Modifiers */
+
+  /* Lookup */
+  template <class Key>
+  [[nodiscard]] bool contains(const Key &key) const noexcept {
+    bool found = true;
+    for_each_slot(m_hash(key),
+                  [this, &found](std::size_t slot) { found &= get(slot) != 0; });
+    return found;
+  }
+  /* Lookup */
+
+  /* Capacity */
+  static constexpr std::size_t size() noexcept {
+    return num_blocks * block_counters;
+  }
+  /* Capacity */
+};
+
+} // namespace eden
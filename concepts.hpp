@@ -1,12 +1,62 @@
 #pragma once
 #include "type_traits.hpp"
 #include <concepts>
+#include <cstddef>
 #include <utility>
 
+#if __has_include(<stdfloat>)
+#include <stdfloat>
+#endif
+
 namespace eden {
 
+#if EDEN_HAS_BUILTIN(__is_same)
+template <class First, class Second>
+concept same_c = __is_same(First, Second);
+#else
 template <class First, class Second>
 concept same_c = is_same_struct<First, Second>::value;
+#endif
+
+// the standard defines the integral and floating point types by listing them,
+// the portable concepts below do the same
+namespace concepts_detail {
+template <class T, class... Listed>
+concept one_of_c = (same_c<T, Listed> || ...);
+
+template <class T> inline constexpr bool is_extended_integral = false;
+template <class T> inline constexpr bool is_extended_floating_point = false;
+
+#if defined(__SIZEOF_INT128__)
+template <> inline constexpr bool is_extended_integral<__int128> = true;
+template <>
+inline constexpr bool is_extended_integral<unsigned __int128> = true;
+#endif
+
+#if defined(__SIZEOF_FLOAT128__)
+template <> inline constexpr bool is_extended_floating_point<__float128> = true;
+#endif
+#if defined(__STDCPP_FLOAT16_T__)
+template <>
+inline constexpr bool is_extended_floating_point<std::float16_t> = true;
+#endif
+#if defined(__STDCPP_FLOAT32_T__)
+template <>
+inline constexpr bool is_extended_floating_point<std::float32_t> = true;
+#endif
+#if defined(__STDCPP_FLOAT64_T__)
+template <>
+inline constexpr bool is_extended_floating_point<std::float64_t> = true;
+#endif
+#if defined(__STDCPP_FLOAT128_T__)
+template <>
+inline constexpr bool is_extended_floating_point<std::float128_t> = true;
+#endif
+#if defined(__STDCPP_BFLOAT16_T__)
+template <>
+inline constexpr bool is_extended_floating_point<std::bfloat16_t> = true;
+#endif
+} // namespace concepts_detail
 
 template <class T, class... Args>
 concept constructible_with_c = requires { T(declval<Args>()...); };
@@ -47,11 +97,21 @@ template <class T>
 concept move_constructible_c =
     constructible_from_c<T, T> && convertible_c<T, T>;
 
+#if EDEN_HAS_BUILTIN(__is_lvalue_reference)
+template <class T>
+concept lvalue_ref_c = __is_lvalue_reference(T);
+#else
 template <class T>
 concept lvalue_ref_c = same_c<T, remove_ref<T> &>;
+#endif
 
+#if EDEN_HAS_BUILTIN(__is_rvalue_reference)
+template <class T>
+concept rvalue_ref_c = __is_rvalue_reference(T);
+#else
 template <class T>
 concept rvalue_ref_c = same_c<T, remove_ref<T> &&>;
+#endif
 
 template <class T>
 concept non_ref_c = same_c<T, remove_ref<T>>;
@@ -70,48 +130,107 @@ concept assignable_from_c =
 
 // unfortunately std::is_union and std::is_enum are not possible to be
 // implemented w/o compiler magic
+#if EDEN_HAS_BUILTIN(__is_union)
+template <class T>
+concept union_c = __is_union(T);
+#else
 template <class T>
 concept union_c = std::is_union_v<T>;
+#endif
 
+#if EDEN_HAS_BUILTIN(__is_enum)
+template <class T>
+concept enum_c = __is_enum(T);
+#else
 template <class T>
 concept enum_c = std::is_enum_v<T>;
+#endif
 
+#if EDEN_HAS_BUILTIN(__is_class)
+template <class T>
+concept class_c = __is_class(T);
+#else
 template <class T>
 concept class_c = !union_c<T> && requires(int T::*) { 0; };
+#endif
 
+#if EDEN_HAS_BUILTIN(__is_array)
 template <class T>
-concept fundamental_c = !class_c<T> && !union_c<T> && !enum_c<T>;
-
+concept array_c = __is_array(T);
+#else
 template <class T>
-concept array_c = requires(T &a) { []<std::size_t N>(auto(&)[N]) {}(a); } ||
-                  requires(T &a) { [](auto(&)[]) {}(a); };
+concept array_c = is_array_struct<T>::value;
+#endif
 
+#if EDEN_HAS_BUILTIN(__is_pointer)
+template <class T>
+concept pointer_c = __is_pointer(T);
+#else
 template <class T>
-concept pointer_c = fundamental_c<T> && !array_c<T> && requires(T a) { *a; };
+concept pointer_c = is_pointer_struct<remove_cv<T>>::value;
+#endif
 
+#if EDEN_HAS_BUILTIN(__is_void)
 template <class T>
-concept void_c = same_c<void, T>;
+concept void_c = __is_void(T);
+#else
+template <class T>
+concept void_c = same_c<void, remove_cv<T>>;
+#endif
 
+#if EDEN_HAS_BUILTIN(__is_member_pointer)
 template <class T>
-concept member_pointer_c = requires(T a) {
-  []<typename Class, typename Member>(Class Member::*) {}(a);
-};
+concept member_pointer_c = __is_member_pointer(T);
+#else
+template <class T>
+concept member_pointer_c = is_member_pointer_struct<remove_cv<T>>::value;
+#endif
 
 template <class T>
-concept null_pointer_c = same_c<T, decltype(nullptr)>;
+concept null_pointer_c = same_c<remove_cv<T>, decltype(nullptr)>;
 
+#if EDEN_HAS_BUILTIN(__is_integral)
 template <class T>
-concept integral_c = fundamental_c<T> && requires(T a, T *p) { p + a; };
+concept integral_c = __is_integral(T);
+#else
+template <class T>
+concept integral_c =
+    concepts_detail::one_of_c<remove_cv<T>, bool, char, signed char,
+                              unsigned char, wchar_t, char8_t, char16_t,
+                              char32_t, short, unsigned short, int, unsigned,
+                              long, unsigned long, long long,
+                              unsigned long long> ||
+    concepts_detail::is_extended_integral<remove_cv<T>>;
+#endif
 
 template <class T>
 concept integral_like_c = requires(T a, T *p) { p + a; };
 
+#if EDEN_HAS_BUILTIN(__is_floating_point)
+template <class T>
+concept floating_point_c = __is_floating_point(T);
+#else
 template <class T>
 concept floating_point_c =
-    !integral_c<T> && fundamental_c<T> && requires(T a, T b) { a + b; };
+    concepts_detail::one_of_c<remove_cv<T>, float, double, long double> ||
+    concepts_detail::is_extended_floating_point<remove_cv<T>>;
+#endif
 
+#if EDEN_HAS_BUILTIN(__is_arithmetic)
+template <class T>
+concept arithmetic_c = __is_arithmetic(T);
+#else
 template <class T>
 concept arithmetic_c = integral_c<T> || floating_point_c<T>;
+#endif
+
+#if EDEN_HAS_BUILTIN(__is_fundamental)
+template <class T>
+concept fundamental_c = __is_fundamental(T);
+#else
+template <class T>
+concept fundamental_c = arithmetic_c<T> || void_c<T> || null_pointer_c<T>;
+#endif
 
 template <class T>
 concept signed_c = arithmetic_c<T> && T(-1) < T(1);
@@ -137,12 +256,22 @@ concept signed_integral_like_c = integral_like_c<T> && signed_like_c<T>;
 template <class T>
 concept unsigned_integral_like_c = integral_like_c<T> && !signed_like_c<T>;
 
+#if EDEN_HAS_BUILTIN(__is_scalar)
+template <class T>
+concept scalar_c = __is_scalar(T);
+#else
 template <class T>
 concept scalar_c = arithmetic_c<T> || enum_c<T> || pointer_c<T> ||
                    member_pointer_c<T> || null_pointer_c<T>;
+#endif
 
+#if EDEN_HAS_BUILTIN(__is_object)
+template <class T>
+concept object_c = __is_object(T);
+#else
 template <class T>
 concept object_c = scalar_c<T> || array_c<T> || union_c<T> || class_c<T>;
+#endif
 
 template <class T>
 concept swappable_c = true; // implement this when you do swap
@@ -158,17 +287,37 @@ concept weakly_incrementable_c = moveable_c<I> && requires(I i) {
   i++;
 };
 
+#if EDEN_HAS_BUILTIN(__is_const)
+template <class T>
+concept const_c = __is_const(T);
+#else
 template <class T>
 concept const_c = !same_c<remove_const<T>, T>;
+#endif
 
+#if EDEN_HAS_BUILTIN(__is_volatile)
+template <class T>
+concept volatile_c = __is_volatile(T);
+#else
 template <class T>
 concept volatile_c = !same_c<remove_volatile<T>, T>;
+#endif
 
+#if EDEN_HAS_BUILTIN(__is_reference)
+template <class T>
+concept reference_c = __is_reference(T);
+#else
 template <class T>
 concept reference_c = !same_c<remove_ref<T>, T>;
+#endif
 
+#if EDEN_HAS_BUILTIN(__is_function)
+template <class T>
+concept function_c = __is_function(T);
+#else
 template <class T>
 concept function_c = !const_c<const T> && !reference_c<T>;
+#endif
 
 template <class T>
 concept referenceable_c = object_c<T> || function_c<T> || reference_c<T>;
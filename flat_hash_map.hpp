@@ -0,0 +1,876 @@
+#pragma once
+#include "memory.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define EDEN_HASH_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace eden {
+
+/* Open addressing with SwissTable style metadata: one control byte per slot
+ * holding either 7 bits of the hash or an empty/deleted marker. A lookup
+ * compares a whole 16-byte group of control bytes against the wanted hash
+ * bits at once and only touches slots that match.
+ *
+ * Control bytes and slots share one allocation from Allocator. Until the
+ * table outgrows InlineCapacity elements they live unhashed in an inline
+ * buffer, the same way StackVector keeps its first elements in
+ * m_stack_buffer, so small maps never allocate.
+ */
+namespace hash_detail {
+
+using ctrl_t = std::int8_t;
+
+inline constexpr ctrl_t ctrl_empty = -128;  // 0b10000000
+inline constexpr ctrl_t ctrl_deleted = -2;  // 0b11111110
+inline constexpr std::size_t group_width = 16;
+inline constexpr std::size_t min_capacity = group_width;
+
+constexpr bool is_full(ctrl_t ctrl) noexcept { return ctrl >= 0; }
+
+// spreads weak hashes (identity std::hash for integers) over all 64 bits
+constexpr std::uint64_t mix(std::uint64_t x) noexcept {
+  x ^= x >> 32;
+  x *= 0xd6e8feb86659fd93ull;
+  x ^= x >> 32;
+  return x;
+}
+
+// set of slot offsets inside a group, one bit per slot
+class bit_mask {
+  std::uint32_t m_mask;
+
+public:
+  explicit constexpr bit_mask(std::uint32_t mask) noexcept : m_mask(mask) {}
+
+  constexpr explicit operator bool() const noexcept { return m_mask != 0; }
+  constexpr unsigned lowest() const noexcept {
+    return std::countr_zero(m_mask);
+  }
+  constexpr void remove_lowest() noexcept { m_mask &= m_mask - 1; }
+};
+
+struct group {
+#ifdef EDEN_HASH_SSE2
+  __m128i m_ctrl;
+
+  explicit group(const ctrl_t *ctrl) noexcept
+      : m_ctrl(_mm_load_si128(reinterpret_cast<const __m128i *>(ctrl))) {}
+
+  bit_mask match(ctrl_t h2) const noexcept {
+    return bit_mask(static_cast<std::uint32_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), m_ctrl))));
+  }
+
+  bit_mask match_empty() const noexcept { return match(ctrl_empty); }
+
+  // empty and deleted are the only control bytes with the sign bit set
+  bit_mask match_empty_or_deleted() const noexcept {
+    return bit_mask(static_cast<std::uint32_t>(_mm_movemask_epi8(m_ctrl)));
+  }
+#else
+  ctrl_t m_ctrl[group_width];
+
+  explicit group(const ctrl_t *ctrl) noexcept {
+    std::memcpy(m_ctrl, ctrl, group_width);
+  }
+
+  template <class Predicate>
+  bit_mask match_if(Predicate pred) const noexcept {
+    std::uint32_t mask{};
+    for (std::size_t i{}; i < group_width; ++i)
+      mask |= static_cast<std::uint32_t>(pred(m_ctrl[i])) << i;
+
+    return bit_mask(mask);
+  }
+
+  bit_mask match(ctrl_t h2) const noexcept {
+    return match_if([h2](ctrl_t c) { return c == h2; });
+  }
+
+  bit_mask match_empty() const noexcept { return match(ctrl_empty); }
+
+  bit_mask match_empty_or_deleted() const noexcept {
+    return match_if([](ctrl_t c) { return c < 0; });
+  }
+#endif
+};
+
+// triangular probing over groups, visits every group when their count is a
+// power of two
+class probe_seq {
+  std::size_t m_mask;
+  std::size_t m_offset;
+  std::size_t m_index{0};
+
+public:
+  constexpr probe_seq(std::size_t hash, std::size_t group_mask) noexcept
+      : m_mask(group_mask), m_offset(hash & group_mask) {}
+
+  constexpr std::size_t offset() const noexcept {
+    return m_offset * group_width;
+  }
+  constexpr std::size_t index() const noexcept { return m_index; }
+  constexpr void next() noexcept {
+    ++m_index;
+    m_offset = (m_offset + m_index) & m_mask;
+  }
+};
+
+template <class Hash, class KeyEqual>
+concept transparent_c = requires {
+  typename Hash::is_transparent;
+  typename KeyEqual::is_transparent;
+};
+
+} // namespace hash_detail
+
+// distance of every element from its ideal group, computed on demand by
+// FlatHashTable::probe_statistics so lookups carry no counters
+struct probe_statistics {
+  std::size_t m_size{};
+  std::size_t m_capacity{};
+  std::size_t m_tombstones{};
+  std::size_t m_max_probe_length{};
+  double m_mean_probe_length{};
+  // m_histogram[i] is the number of elements found i groups past their home
+  std::vector<std::size_t> m_histogram;
+};
+
+/* Shared implementation of flat_hash_map and flat_hash_set. Mapped is void
+ * for sets. Erasing or rehashing invalidates iterators, and in inline mode
+ * erasing moves the last element into the freed slot.
+ *
+ * Map slots hold a pair<Key, Mapped> and are handed out as value_type,
+ * pair<const Key, Mapped>, which has the same layout. The table itself goes
+ * through slot_of, so rehashing and erasing move keys instead of copying
+ * them.
+ */
+template <class Key, class Mapped, class Hash, class KeyEqual,
+          class Allocator, std::size_t InlineCapacity>
+class FlatHashTable {
+public:
+  using key_type = Key;
+  using value_type =
+      std::conditional_t<std::is_void_v<Mapped>, Key,
+                         std::pair<const Key, Mapped>>;
+  using size_type = std::size_t;
+  using hasher = Hash;
+  using key_equal = KeyEqual;
+
+protected:
+  using ctrl_t = hash_detail::ctrl_t;
+  static constexpr bool is_set = std::is_void_v<Mapped>;
+  static constexpr size_type value_size = sizeof(value_type);
+
+  using slot_type =
+      std::conditional_t<is_set, Key, std::pair<Key, Mapped>>;
+
+  static_assert(sizeof(slot_type) == sizeof(value_type) &&
+                    alignof(slot_type) == alignof(value_type),
+                "slots must have the layout of value_type");
+
+  static_assert(alignof(value_type) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__,
+                "over-aligned elements are not supported");
+
+  [[no_unique_address]] Hash m_hash;
+  [[no_unique_address]] KeyEqual m_eq;
+  [[no_unique_address]] Allocator m_alloc;
+  size_type m_size{0};
+  size_type m_capacity{0}; // 0 while in inline mode
+  size_type m_growth_left{0};
+  ctrl_t *m_ctrl{nullptr};
+  value_type *m_slots{nullptr};
+  alignas(value_type) std::byte
+      m_inline_buffer[(InlineCapacity ? InlineCapacity : 1) * value_size];
+
+  template <class K>
+  using lookup_key =
+      std::conditional_t<hash_detail::transparent_c<Hash, KeyEqual>, K, Key>;
+
+  static const Key &key_of(const value_type &value) noexcept {
+    if constexpr (is_set)
+      return value;
+    else
+      return value.first;
+  }
+
+  static slot_type *slot_of(value_type *value) noexcept {
+    return std::launder(reinterpret_cast<slot_type *>(value));
+  }
+
+  template <class... Args>
+  static value_type *construct_slot(value_type *slot, Args &&...args) {
+    std::construct_at(reinterpret_cast<slot_type *>(slot),
+                      std::forward<Args>(args)...);
+    return std::launder(slot);
+  }
+
+  static void destroy_slot(value_type *slot) noexcept {
+    std::destroy_at(slot_of(slot));
+  }
+
+  value_type *inline_slots() noexcept {
+    return std::launder(reinterpret_cast<value_type *>(m_inline_buffer));
+  }
+  const value_type *inline_slots() const noexcept {
+    return std::launder(reinterpret_cast<const value_type *>(m_inline_buffer));
+  }
+
+  bool is_inline() const noexcept { return m_ctrl == nullptr; }
+
+  template <class K> std::uint64_t hash_of(const K &key) const {
+    return hash_detail::mix(static_cast<std::uint64_t>(m_hash(key)));
+  }
+
+  static constexpr size_type max_load(size_type capacity) noexcept {
+    return capacity - capacity / 8;
+  }
+
+  static constexpr size_type capacity_for(size_type count) noexcept {
+    size_type capacity = hash_detail::min_capacity;
+    while (max_load(capacity) < count)
+      capacity *= 2;
+
+    return capacity;
+  }
+
+  static constexpr size_type ctrl_bytes(size_type capacity) noexcept {
+    return capacity; // capacity is a multiple of the group width
+  }
+
+  static constexpr size_type alloc_bytes(size_type capacity) noexcept {
+    return ctrl_bytes(capacity) + capacity * value_size;
+  }
+
+  void set_ctrl(size_type index, ctrl_t value) noexcept {
+    m_ctrl[index] = value;
+  }
+
+  /* Table mode helpers */
+  template <class K>
+  value_type *find_in_table(const K &key, std::uint64_t hash) const {
+    const ctrl_t h2 = static_cast<ctrl_t>(hash & 0x7f);
+    hash_detail::probe_seq seq(hash >> 7, m_capacity / hash_detail::group_width - 1);
+
+    while (true) {
+      const hash_detail::group g(m_ctrl + seq.offset());
+      for (auto match = g.match(h2); match; match.remove_lowest()) {
+        value_type *const slot = m_slots + seq.offset() + match.lowest();
+        if (m_eq(key_of(*slot), key)) [[likely]]
+          return slot;
+      }
+
+      if (g.match_empty()) [[likely]]
+        return nullptr;
+
+      seq.next();
+    }
+  }
+
+  static size_type find_free_slot(const ctrl_t *ctrl, size_type capacity,
+                                  std::uint64_t hash) noexcept {
+    hash_detail::probe_seq seq(hash >> 7, capacity / hash_detail::group_width - 1);
+
+    while (true) {
+      const hash_detail::group g(ctrl + seq.offset());
+      if (auto free = g.match_empty_or_deleted())
+        return seq.offset() + free.lowest();
+
+      seq.next();
+    }
+  }
+
+  size_type find_free_slot(std::uint64_t hash) const noexcept {
+    return find_free_slot(m_ctrl, m_capacity, hash);
+  }
+
+  /* Moves every element into a fresh allocation of new_capacity slots. The
+   * new block only replaces the old one once it holds every element, so if a
+   * hash or a copy throws it is released and the table keeps its old block
+   * and size. Elements are moved when that cannot throw and copied
+   * otherwise; a throwing hash after some moves leaves those moved-from.
+   */
+  void rehash_into(size_type new_capacity) {
+    std::byte *const memory = m_alloc.allocate(alloc_bytes(new_capacity));
+    if (!memory)
+      throw std::bad_alloc();
+
+    ctrl_t *const new_ctrl = reinterpret_cast<ctrl_t *>(memory);
+    value_type *const new_slots =
+        reinterpret_cast<value_type *>(memory + ctrl_bytes(new_capacity));
+    std::memset(new_ctrl, static_cast<unsigned char>(hash_detail::ctrl_empty),
+                ctrl_bytes(new_capacity));
+
+    const auto move_in = [&](value_type &old) {
+      const std::uint64_t hash = hash_of(key_of(old));
+      const size_type index = find_free_slot(new_ctrl, new_capacity, hash);
+      construct_slot(new_slots + index, std::move_if_noexcept(*slot_of(&old)));
+      new_ctrl[index] = static_cast<ctrl_t>(hash & 0x7f);
+    };
+
+    try {
+      if (is_inline()) {
+        for (size_type i{}; i < m_size; ++i)
+          move_in(inline_slots()[i]);
+      } else {
+        for (size_type i{}; i < m_capacity; ++i)
+          if (hash_detail::is_full(m_ctrl[i]))
+            move_in(m_slots[i]);
+      }
+    } catch (...) {
+      for (size_type i{}; i < new_capacity; ++i)
+        if (hash_detail::is_full(new_ctrl[i]))
+          destroy_slot(new_slots + i);
+
+      m_alloc.deallocate(memory, alloc_bytes(new_capacity));
+      throw;
+    }
+
+    const size_type size = m_size;
+    destroy_all();
+    m_size = size;
+    m_capacity = new_capacity;
+    m_growth_left = max_load(new_capacity) - size;
+    m_ctrl = new_ctrl;
+    m_slots = new_slots;
+  }
+
+  /* Called when no growth is left. Tombstones count against growth, so if
+   * at least half of the used load is tombstones the table is rebuilt at the
+   * same size, which clears them, instead of doubling.
+   */
+  void make_room() {
+    if (m_capacity != 0 && m_size <= max_load(m_capacity) / 2)
+      rehash_into(m_capacity);
+    else
+      rehash_into(m_capacity ? m_capacity * 2 : capacity_for(m_size + 1));
+  }
+
+  template <class K, class... Args>
+  std::pair<value_type *, bool> emplace_unique(const K &key, Args &&...args) {
+    if (is_inline()) {
+      value_type *const slots = inline_slots();
+      for (size_type i{}; i < m_size; ++i)
+        if (m_eq(key_of(slots[i]), key))
+          return {slots + i, false};
+
+      if (m_size < InlineCapacity) {
+        value_type *const slot =
+            construct_slot(slots + m_size, std::forward<Args>(args)...);
+        ++m_size;
+        return {slot, true};
+      }
+
+      rehash_into(capacity_for(m_size + 1));
+    }
+
+    const std::uint64_t hash = hash_of(key);
+    if (value_type *const found = find_in_table(key, hash))
+      return {found, false};
+
+    size_type index = find_free_slot(hash);
+    if (m_growth_left == 0 && m_ctrl[index] != hash_detail::ctrl_deleted) {
+      make_room();
+      index = find_free_slot(hash);
+    }
+
+    value_type *const slot =
+        construct_slot(m_slots + index, std::forward<Args>(args)...);
+    if (m_ctrl[index] == hash_detail::ctrl_empty)
+      --m_growth_left;
+    set_ctrl(index, static_cast<ctrl_t>(hash & 0x7f));
+    ++m_size;
+    return {slot, true};
+  }
+
+  void erase_slot(value_type *slot) {
+    --m_size;
+
+    if (is_inline()) {
+      value_type *const last = inline_slots() + m_size;
+      if (slot != last) {
+        destroy_slot(slot);
+        construct_slot(slot, std::move(*slot_of(last)));
+      }
+      destroy_slot(last);
+      return;
+    }
+
+    const size_type index = slot - m_slots;
+    destroy_slot(slot);
+
+    // probes only continue past a group with no empty slot, so if this group
+    // has one no probe sequence can depend on the erased slot
+    const hash_detail::group g(m_ctrl + index / hash_detail::group_width *
+                                            hash_detail::group_width);
+    if (g.match_empty()) {
+      set_ctrl(index, hash_detail::ctrl_empty);
+      ++m_growth_left;
+    } else {
+      set_ctrl(index, hash_detail::ctrl_deleted);
+    }
+  }
+
+  void destroy_all() noexcept {
+    if (is_inline()) {
+      for (size_type i{}; i < m_size; ++i)
+        destroy_slot(inline_slots() + i);
+    } else {
+      for (size_type i{}; i < m_capacity; ++i)
+        if (hash_detail::is_full(m_ctrl[i]))
+          destroy_slot(m_slots + i);
+
+      m_alloc.deallocate(reinterpret_cast<std::byte *>(m_ctrl),
+                         alloc_bytes(m_capacity));
+    }
+
+    m_size = 0;
+    m_capacity = 0;
+    m_growth_left = 0;
+    m_ctrl = nullptr;
+    m_slots = nullptr;
+  }
+
+  template <class K> value_type *find_slot(const K &key) const {
+    if (is_inline()) {
+      const value_type *const slots = inline_slots();
+      for (size_type i{}; i < m_size; ++i)
+        if (m_eq(key_of(slots[i]), key))
+          return const_cast<value_type *>(slots + i);
+
+      return nullptr;
+    }
+
+    return find_in_table(key, hash_of(key));
+  }
+
+  template <class Value> class basic_iterator {
+    friend class FlatHashTable;
+
+    const ctrl_t *m_ctrl{nullptr};
+    Value *m_slot{nullptr};
+    Value *m_end{nullptr};
+
+    constexpr basic_iterator(const ctrl_t *ctrl, Value *slot,
+                             Value *end) noexcept
+        : m_ctrl(ctrl), m_slot(slot), m_end(end) {
+      skip_empty();
+    }
+
+    constexpr void skip_empty() noexcept {
+      if (!m_ctrl)
+        return;
+
+      while (m_slot != m_end && !hash_detail::is_full(*m_ctrl)) {
+        ++m_ctrl;
+        ++m_slot;
+      }
+    }
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::remove_const_t<Value>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = Value *;
+    using reference = Value &;
+
+    constexpr basic_iterator() noexcept = default;
+
+    template <class Other>
+      requires std::is_const_v<Value> && (!std::is_const_v<Other>)
+    constexpr basic_iterator(const basic_iterator<Other> &other) noexcept
+        : m_ctrl(other.m_ctrl), m_slot(other.m_slot), m_end(other.m_end) {}
+
+    constexpr reference operator*() const noexcept { return *m_slot; }
+    constexpr pointer operator->() const noexcept { return m_slot; }
+
+    constexpr basic_iterator &operator++() noexcept {
+      ++m_slot;
+      if (m_ctrl) {
+        ++m_ctrl;
+        skip_empty();
+      }
+      return *this;
+    }
+
+    constexpr basic_iterator operator++(int) noexcept {
+      basic_iterator ret_val = *this;
+      ++*this;
+      return ret_val;
+    }
+
+    friend constexpr bool operator==(const basic_iterator &lhs,
+                                     const basic_iterator &rhs) noexcept {
+      return lhs.m_slot == rhs.m_slot;
+    }
+
+    template <class> friend class basic_iterator;
+  };
+
+public:
+  using iterator =
+      basic_iterator<std::conditional_t<is_set, const value_type, value_type>>;
+  using const_iterator = basic_iterator<const value_type>;
+
+protected:
+  iterator make_iterator(value_type *slot) noexcept {
+    if (!slot)
+      return end();
+    if (is_inline())
+      return iterator(nullptr, slot, inline_slots() + m_size);
+
+    return iterator(m_ctrl + (slot - m_slots), slot, m_slots + m_capacity);
+  }
+
+  const_iterator make_iterator(const value_type *slot) const noexcept {
+    if (!slot)
+      return end();
+    if (is_inline())
+      return const_iterator(nullptr, slot, inline_slots() + m_size);
+
+    return const_iterator(m_ctrl + (slot - m_slots), slot,
+                          m_slots + m_capacity);
+  }
+
+public:
+  /* Special Member Functions */
+  constexpr FlatHashTable() noexcept(noexcept(Allocator()))
+      : FlatHashTable(0) {}
+
+  explicit FlatHashTable(size_type bucket_count, const Hash &hash = Hash(),
+                         const KeyEqual &eq = KeyEqual(),
+                         const Allocator &alloc = Allocator())
+      : m_hash(hash), m_eq(eq), m_alloc(alloc) {
+    if (bucket_count)
+      reserve(bucket_count);
+  }
+
+  FlatHashTable(const FlatHashTable &other)
+      : m_hash(other.m_hash), m_eq(other.m_eq), m_alloc(other.m_alloc) {
+    reserve(other.m_size);
+    for (const auto &value : other)
+      emplace_unique(key_of(value), value);
+  }
+
+  FlatHashTable(FlatHashTable &&other) noexcept(
+      std::is_nothrow_move_constructible_v<slot_type>)
+      : m_hash(std::move(other.m_hash)), m_eq(std::move(other.m_eq)),
+        m_alloc(std::move_if_noexcept(other.m_alloc)) {
+    take(other);
+  }
+
+  ~FlatHashTable() noexcept { destroy_all(); }
+
+  FlatHashTable &operator=(const FlatHashTable &other) {
+    if (this != &other) {
+      FlatHashTable copy(other);
+      *this = std::move(copy);
+    }
+
+    return *this;
+  }
+
+  FlatHashTable &operator=(FlatHashTable &&other) noexcept(
+      std::is_nothrow_move_constructible_v<slot_type>) {
+    if (this != &other) {
+      destroy_all();
+      m_hash = std::move(other.m_hash);
+      m_eq = std::move(other.m_eq);
+      m_alloc = std::move_if_noexcept(other.m_alloc);
+      take(other);
+    }
+
+    return *this;
+  }
+  /* Special Member Functions */
+
+private:
+  void take(FlatHashTable &other) {
+    if (other.is_inline()) {
+      for (size_type i{}; i < other.m_size; ++i) {
+        construct_slot(inline_slots() + i,
+                       std::move(*slot_of(other.inline_slots() + i)));
+        destroy_slot(other.inline_slots() + i);
+      }
+      m_size = other.m_size;
+      other.m_size = 0;
+      return;
+    }
+
+    m_size = std::exchange(other.m_size, 0);
+    m_capacity = std::exchange(other.m_capacity, 0);
+    m_growth_left = std::exchange(other.m_growth_left, 0);
+    m_ctrl = std::exchange(other.m_ctrl, nullptr);
+    m_slots = std::exchange(other.m_slots, nullptr);
+  }
+
+public:
+  /* Iterators */
+  iterator begin() noexcept {
+    if (is_inline())
+      return iterator(nullptr, inline_slots(), inline_slots() + m_size);
+
+    return iterator(m_ctrl, m_slots, m_slots + m_capacity);
+  }
+
+  const_iterator begin() const noexcept {
+    if (is_inline())
+      return const_iterator(nullptr, inline_slots(), inline_slots() + m_size);
+
+    return const_iterator(m_ctrl, m_slots, m_slots + m_capacity);
+  }
+
+  iterator end() noexcept {
+    value_type *const last =
+        is_inline() ? inline_slots() + m_size : m_slots + m_capacity;
+    return iterator(nullptr, last, last);
+  }
+
+  const_iterator end() const noexcept {
+    const value_type *const last =
+        is_inline() ? inline_slots() + m_size : m_slots + m_capacity;
+    return const_iterator(nullptr, last, last);
+  }
+  /* Iterators */
+
+  /* Capacity */
+  [[nodiscard]] bool is_empty() const noexcept { return m_size == 0; }
+  [[nodiscard]] size_type size() const noexcept { return m_size; }
+  [[nodiscard]] size_type capacity() const noexcept {
+    return is_inline() ? InlineCapacity : m_capacity;
+  }
+
+  // makes room for count elements in total, inserting up to that many will
+  // not rehash
+  void reserve(size_type count) {
+    if (count <= size())
+      return;
+    if (is_inline() && count <= InlineCapacity)
+      return;
+
+    const size_type needed = capacity_for(count);
+    if (is_inline() || needed > m_capacity ||
+        m_growth_left < count - m_size)
+      rehash_into(std::max(needed, m_capacity));
+  }
+
+  void rehash(size_type count) {
+    if (!is_inline())
+      rehash_into(std::max(capacity_for(m_size), capacity_for(count)));
+  }
+
+  [[nodiscard]] probe_statistics probe_stats() const {
+    probe_statistics stats;
+    stats.m_size = m_size;
+    stats.m_capacity = capacity();
+    if (is_inline() || m_size == 0)
+      return stats;
+
+    std::size_t total{};
+    const size_type num_groups = m_capacity / hash_detail::group_width;
+    for (size_type i{}; i < m_capacity; ++i) {
+      if (m_ctrl[i] == hash_detail::ctrl_deleted)
+        ++stats.m_tombstones;
+      if (!hash_detail::is_full(m_ctrl[i]))
+        continue;
+
+      hash_detail::probe_seq seq(hash_of(key_of(m_slots[i])) >> 7,
+                                 num_groups - 1);
+      while (seq.offset() != i / hash_detail::group_width *
+                                 hash_detail::group_width)
+        seq.next();
+
+      const std::size_t length = seq.index();
+      if (stats.m_histogram.size() <= length)
+        stats.m_histogram.resize(length + 1);
+      ++stats.m_histogram[length];
+      stats.m_max_probe_length = std::max(stats.m_max_probe_length, length);
+      total += length;
+    }
+
+    stats.m_mean_probe_length = static_cast<double>(total) / m_size;
+    return stats;
+  }
+  /* Capacity */
+
+  /* Lookup */
+  template <class K>
+  [[nodiscard]] iterator find(const K &key) {
+    return make_iterator(find_slot<lookup_key<K>>(key));
+  }
+
+  template <class K>
+  [[nodiscard]] const_iterator find(const K &key) const {
+    return make_iterator(
+        static_cast<const value_type *>(find_slot<lookup_key<K>>(key)));
+  }
+
+  template <class K> [[nodiscard]] bool contains(const K &key) const {
+    return find_slot<lookup_key<K>>(key) != nullptr;
+  }
+
+  template <class K> [[nodiscard]] size_type count(const K &key) const {
+    return contains(key);
+  }
+  /* Lookup */
+
+  /* Modifiers */
+  void clear() noexcept { destroy_all(); }
+
+  template <class K> size_type erase(const K &key) {
+    value_type *const slot = find_slot<lookup_key<K>>(key);
+    if (!slot)
+      return 0;
+
+    erase_slot(slot);
+    return 1;
+  }
+
+  void erase(const_iterator pos) {
+    erase_slot(const_cast<value_type *>(pos.m_slot));
+  }
+
+  void erase(iterator pos)
+    requires(!std::is_same_v<iterator, const_iterator>)
+  {
+    erase_slot(const_cast<value_type *>(pos.m_slot));
+  }
+  /* Modifiers */
+};
+
+template <class Key, class T, class Hash = std::hash<Key>,
+          class KeyEqual = std::equal_to<Key>,
+          class Allocator = allocator<std::byte>,
+          std::size_t InlineCapacity = 4>
+class flat_hash_map
+    : public FlatHashTable<Key, T, Hash, KeyEqual, Allocator, InlineCapacity> {
+  using base =
+      FlatHashTable<Key, T, Hash, KeyEqual, Allocator, InlineCapacity>;
+
+public:
+  using mapped_type = T;
+  using typename base::iterator;
+  using typename base::value_type;
+
+  using base::base;
+
+  flat_hash_map(std::initializer_list<value_type> init) {
+    this->reserve(init.size());
+    for (const auto &value : init)
+      insert(value);
+  }
+
+  /* Modifiers */
+  std::pair<iterator, bool> insert(const value_type &value) {
+    auto [slot, inserted] = this->emplace_unique(value.first, value);
+    return {this->make_iterator(slot), inserted};
+  }
+
+  std::pair<iterator, bool> insert(value_type &&value) {
+    auto [slot, inserted] =
+        this->emplace_unique(value.first, std::move(value));
+    return {this->make_iterator(slot), inserted};
+  }
+
+  template <class... Args>
+  std::pair<iterator, bool> try_emplace(const Key &key, Args &&...args) {
+    auto [slot, inserted] = this->emplace_unique(
+        key, std::piecewise_construct, std::forward_as_tuple(key),
+        std::forward_as_tuple(std::forward<Args>(args)...));
+    return {this->make_iterator(slot), inserted};
+  }
+
+  template <class... Args>
+  std::pair<iterator, bool> try_emplace(Key &&key, Args &&...args) {
+    const Key &lookup = key;
+    auto [slot, inserted] = this->emplace_unique(
+        lookup, std::piecewise_construct, std::forward_as_tuple(std::move(key)),
+        std::forward_as_tuple(std::forward<Args>(args)...));
+    return {this->make_iterator(slot), inserted};
+  }
+
+  template <class K, class V>
+  std::pair<iterator, bool> emplace(K &&key, V &&value) {
+    return try_emplace(Key(std::forward<K>(key)), std::forward<V>(value));
+  }
+
+  T &operator[](const Key &key) { return try_emplace(key).first->second; }
+  T &operator[](Key &&key) {
+    return try_emplace(std::move(key)).first->second;
+  }
+  /* Modifiers */
+
+  /* Element Access */
+  template <class K> [[nodiscard]] T &at(const K &key) {
+    auto found = this->find(key);
+    if (found == this->end())
+      throw std::runtime_error("key not found in flat_hash_map");
+
+    return found->second;
+  }
+
+  template <class K> [[nodiscard]] const T &at(const K &key) const {
+    auto found = this->find(key);
+    if (found == this->end())
+      throw std::runtime_error("key not found in flat_hash_map");
+
+    return found->second;
+  }
+  /* Element Access */
+};
+
+template <class Key, class Hash = std::hash<Key>,
+          class KeyEqual = std::equal_to<Key>,
+          class Allocator = allocator<std::byte>,
+          std::size_t InlineCapacity = 4>
+class flat_hash_set : public FlatHashTable<Key, void, Hash, KeyEqual,
+                                           Allocator, InlineCapacity> {
+  using base =
+      FlatHashTable<Key, void, Hash, KeyEqual, Allocator, InlineCapacity>;
+
+public:
+  using typename base::iterator;
+  using typename base::value_type;
+
+  using base::base;
+
+  flat_hash_set(std::initializer_list<Key> init) {
+    this->reserve(init.size());
+    for (const auto &key : init)
+      insert(key);
+  }
+
+  /* Modifiers */
+  std::pair<iterator, bool> insert(const Key &key) {
+    auto [slot, inserted] = this->emplace_unique(key, key);
+    return {this->make_iterator(slot), inserted};
+  }
+
+  std::pair<iterator, bool> insert(Key &&key) {
+    const Key &lookup = key;
+    auto [slot, inserted] = this->emplace_unique(lookup, std::move(key));
+    return {this->make_iterator(slot), inserted};
+  }
+
+  template <class... Args> std::pair<iterator, bool> emplace(Args &&...args) {
+    return insert(Key(std::forward<Args>(args)...));
+  }
+  /* Modifiers */
+};
+
+} // namespace eden
@@ -0,0 +1,589 @@
+#pragma once
+#include "bitset.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace eden {
+
+/* File-backed containers. The file holds a small versioned header followed
+ * by the raw elements, and is used in place through a shared mapping:
+ * reopening after a restart is an mmap plus a header check, with no parsing
+ * or copying. POSIX only.
+ */
+
+enum class mapped_mode {
+  create,     // create or truncate the file, read-write
+  read_write, // open an existing file, read-write
+  read_only,  // open an existing file, read-only and zero-copy, for views
+};
+
+struct mapped_header {
+  static constexpr char magic[8] = {'E', 'D', 'E', 'N', 'M', 'A', 'P', '\0'};
+  static constexpr std::uint32_t format_version = 1;
+  static constexpr std::uint32_t byte_order_mark = 0x01020304;
+
+  enum kind : std::uint32_t { vector_kind = 1, bitset_kind = 2 };
+
+  char m_magic[8];
+  std::uint32_t m_format_version;
+  std::uint32_t m_byte_order;
+  std::uint32_t m_kind;
+  // caller supplied, lets stale files be rejected when the data layout changes
+  std::uint32_t m_user_version;
+  std::uint64_t m_element_size;
+  std::uint64_t m_element_align;
+  std::uint64_t m_size;
+  std::uint64_t m_capacity;
+};
+
+// elements start one cache line into the file
+inline constexpr std::size_t mapped_data_offset = 64;
+static_assert(sizeof(mapped_header) <= mapped_data_offset);
+
+/* Owns the file descriptor and the mapping. Errors from the OS are thrown as
+ * std::system_error.
+ */
+class mapped_file {
+  int m_fd{-1};
+  std::byte *m_data{nullptr};
+  std::size_t m_length{0};
+  bool m_writable{false};
+
+  [[noreturn]] static void throw_errno(const char *what) {
+    throw std::system_error(errno, std::generic_category(), what);
+  }
+
+  void map(std::size_t length) {
+    const int prot = m_writable ? PROT_READ | PROT_WRITE : PROT_READ;
+    void *const memory = mmap(nullptr, length, prot, MAP_SHARED, m_fd, 0);
+    if (memory == MAP_FAILED)
+      throw_errno("mmap failed in mapped_file");
+
+    m_data = static_cast<std::byte *>(memory);
+    m_length = length;
+  }
+
+  void unmap() noexcept {
+    if (m_data)
+      munmap(m_data, m_length);
+
+    m_data = nullptr;
+    m_length = 0;
+  }
+
+public:
+  /* Special Member Functions */
+  mapped_file() noexcept = default;
+
+  mapped_file(const std::filesystem::path &path, mapped_mode mode,
+              std::size_t create_length = 0)
+      : m_writable(mode != mapped_mode::read_only) {
+    int flags = m_writable ? O_RDWR : O_RDONLY;
+    if (mode == mapped_mode::create)
+      flags |= O_CREAT | O_TRUNC;
+
+    m_fd = ::open(path.c_str(), flags | O_CLOEXEC, 0644);
+    if (m_fd < 0)
+      throw_errno("open failed in mapped_file");
+
+    std::size_t length = create_length;
+    if (mode == mapped_mode::create) {
+      if (ftruncate(m_fd, static_cast<off_t>(length)) != 0) {
+        ::close(m_fd);
+        throw_errno("ftruncate failed in mapped_file");
+      }
+    } else {
+      struct stat info;
+      if (fstat(m_fd, &info) != 0) {
+        ::close(m_fd);
+        throw_errno("fstat failed in mapped_file");
+      }
+      length = static_cast<std::size_t>(info.st_size);
+    }
+
+    try {
+      map(length);
+    } catch (...) {
+      ::close(m_fd);
+      throw;
+    }
+  }
+
+  mapped_file(const mapped_file &) = delete;
+  mapped_file &operator=(const mapped_file &) = delete;
+
+  mapped_file(mapped_file &&other) noexcept
+      : m_fd(std::exchange(other.m_fd, -1)),
+        m_data(std::exchange(other.m_data, nullptr)),
+        m_length(std::exchange(other.m_length, 0)),
+        m_writable(other.m_writable) {}
+
+  mapped_file &operator=(mapped_file &&other) noexcept {
+    if (this != &other) {
+      close();
+      m_fd = std::exchange(other.m_fd, -1);
+      m_data = std::exchange(other.m_data, nullptr);
+      m_length = std::exchange(other.m_length, 0);
+      m_writable = other.m_writable;
+    }
+
+    return *this;
+  }
+
+  ~mapped_file() noexcept { close(); }
+  /* Special Member Functions */
+
+  [[nodiscard]] std::byte *data() const noexcept { return m_data; }
+  [[nodiscard]] std::size_t length() const noexcept { return m_length; }
+  [[nodiscard]] bool is_writable() const noexcept { return m_writable; }
+
+  // grows or shrinks the file, the mapping may move
+  void resize(std::size_t length) {
+    if (!m_writable)
+      throw std::runtime_error("resize of read-only mapped_file");
+    if (ftruncate(m_fd, static_cast<off_t>(length)) != 0)
+      throw_errno("ftruncate failed in mapped_file");
+
+#if defined(__linux__)
+    void *const memory = mremap(m_data, m_length, length, MREMAP_MAYMOVE);
+    if (memory == MAP_FAILED)
+      throw_errno("mremap failed in mapped_file");
+
+    m_data = static_cast<std::byte *>(memory);
+    m_length = length;
+#else
+    unmap();
+    map(length);
+#endif
+  }
+
+  /* Writes dirty pages in [offset, offset + length) back to the file. Without
+   * a flush the kernel still writes them back eventually, a flush only
+   * matters for surviving a machine crash at a known point.
+   */
+  void flush(std::size_t offset, std::size_t length, bool wait = true) {
+    if (!m_writable || !m_data)
+      return;
+
+    const std::size_t page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    const std::size_t first = offset / page * page;
+    if (msync(m_data + first, offset + length - first,
+              wait ? MS_SYNC : MS_ASYNC) != 0)
+      throw_errno("msync failed in mapped_file");
+  }
+
+  void flush(bool wait = true) { flush(0, m_length, wait); }
+
+  // asks the kernel to read the whole file in ahead of use
+  void prefetch() const noexcept {
+    if (m_data)
+      madvise(m_data, m_length, MADV_WILLNEED);
+  }
+
+  void close() noexcept {
+    unmap();
+    if (m_fd >= 0)
+      ::close(m_fd);
+
+    m_fd = -1;
+  }
+};
+
+namespace mapped_detail {
+
+inline mapped_header *init_header(std::byte *data, mapped_header::kind kind,
+                                  std::uint32_t user_version,
+                                  std::uint64_t element_size,
+                                  std::uint64_t element_align) noexcept {
+  auto *const header = std::construct_at(reinterpret_cast<mapped_header *>(data));
+  std::memcpy(header->m_magic, mapped_header::magic, sizeof(header->m_magic));
+  header->m_format_version = mapped_header::format_version;
+  header->m_byte_order = mapped_header::byte_order_mark;
+  header->m_kind = kind;
+  header->m_user_version = user_version;
+  header->m_element_size = element_size;
+  header->m_element_align = element_align;
+  header->m_size = 0;
+  header->m_capacity = 0;
+  return header;
+}
+
+inline mapped_header *check_header(const mapped_file &file,
+                                   mapped_header::kind kind,
+                                   std::uint32_t user_version,
+                                   std::uint64_t element_size,
+                                   std::uint64_t element_align) {
+  if (file.length() < mapped_data_offset)
+    throw std::runtime_error("mapped file too small for a header");
+
+  auto *const header =
+      std::launder(reinterpret_cast<mapped_header *>(file.data()));
+  if (std::memcmp(header->m_magic, mapped_header::magic,
+                  sizeof(header->m_magic)) != 0)
+    throw std::runtime_error("mapped file has no eden header");
+  if (header->m_format_version != mapped_header::format_version)
+    throw std::runtime_error("mapped file format version mismatch");
+  if (header->m_byte_order != mapped_header::byte_order_mark)
+    throw std::runtime_error("mapped file was written with another byte order");
+  if (header->m_kind != kind)
+    throw std::runtime_error("mapped file holds another container kind");
+  if (header->m_user_version != user_version)
+    throw std::runtime_error("mapped file user version mismatch");
+  if (header->m_element_size != element_size ||
+      header->m_element_align != element_align)
+    throw std::runtime_error("mapped file element layout mismatch");
+  // a bitset counts its size in bits and its capacity in words; the capacity
+  // is checked by division since a corrupt one can overflow the product
+  if ((kind == mapped_header::vector_kind &&
+       header->m_size > header->m_capacity) ||
+      header->m_capacity >
+          (file.length() - mapped_data_offset) / element_size)
+    throw std::runtime_error("mapped file is truncated");
+
+  return header;
+}
+
+// the writable containers reject read_only up front, a view reads those
+inline mapped_mode writable_mode(mapped_mode mode, const char *container) {
+  if (mode == mapped_mode::read_only)
+    throw std::runtime_error(std::string(container) +
+                             " opened read_only, use its view instead");
+
+  return mode;
+}
+
+} // namespace mapped_detail
+
+/* Vector of trivially copyable T stored in a file, with StackVector's
+ * interface. The size lives in the mapped header, so it persists along with
+ * the elements. Always writable: a read_only mapping is PROT_READ, so it is
+ * opened as a MappedVectorView, which only has const access, and element
+ * access here never checks the mode.
+ */
+template <class T> class MappedVector {
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  static constexpr size_t value_size = sizeof(T);
+  static constexpr size_t expansion_mod = 2;
+  static constexpr size_type min_capacity = 16;
+
+  static_assert(std::is_trivially_copyable_v<T>,
+                "MappedVector elements are stored as raw bytes");
+  static_assert(alignof(T) <= mapped_data_offset);
+
+  mapped_file m_file;
+  mapped_header *m_header{nullptr};
+  T *m_begin{nullptr};
+
+  void remap_pointers() noexcept {
+    m_header = std::launder(reinterpret_cast<mapped_header *>(m_file.data()));
+    m_begin = reinterpret_cast<T *>(m_file.data() + mapped_data_offset);
+  }
+
+  void grow_to(size_type new_capacity) {
+    m_file.resize(mapped_data_offset + new_capacity * value_size);
+    remap_pointers();
+    m_header->m_capacity = new_capacity;
+  }
+
+  void expand() {
+    grow_to(std::max(min_capacity, capacity() * expansion_mod));
+  }
+
+public:
+  /* Special Member Functions */
+  MappedVector(const std::filesystem::path &path, mapped_mode mode,
+               std::uint32_t user_version = 0, size_type initial_capacity = 0)
+      : m_file(path, mapped_detail::writable_mode(mode, "MappedVector"),
+               mapped_data_offset + initial_capacity * value_size) {
+    if (mode == mapped_mode::create) {
+      m_header = mapped_detail::init_header(
+          m_file.data(), mapped_header::vector_kind, user_version, value_size,
+          alignof(T));
+      m_header->m_capacity = initial_capacity;
+    } else {
+      m_header = mapped_detail::check_header(
+          m_file, mapped_header::vector_kind, user_version, value_size,
+          alignof(T));
+    }
+
+    m_begin = reinterpret_cast<T *>(m_file.data() + mapped_data_offset);
+  }
+
+  MappedVector(const MappedVector &) = delete;
+  MappedVector &operator=(const MappedVector &) = delete;
+  MappedVector(MappedVector &&other) noexcept = default;
+  MappedVector &operator=(MappedVector &&other) noexcept = default;
+  ~MappedVector() noexcept = default;
+  /* Special Member Functions */
+
+  /* Element Access */
+  [[nodiscard]] T &at(size_type pos) {
+    if (pos >= size())
+      throw std::runtime_error("element access beyond bounds in mappedvector");
+
+    return m_begin[pos];
+  }
+
+  [[nodiscard]] const T &at(size_type pos) const {
+    if (pos >= size())
+      throw std::runtime_error("element access beyond bounds in mappedvector");
+
+    return m_begin[pos];
+  }
+
+  [[nodiscard]] T &operator[](size_type pos) noexcept {
+    return m_begin[pos];
+  }
+  [[nodiscard]] const T &operator[](size_type pos) const noexcept {
+    return m_begin[pos];
+  }
+
+  [[nodiscard]] T &front() { return m_begin[0]; }
+  [[nodiscard]] const T &front() const { return m_begin[0]; }
+  [[nodiscard]] T &back() { return m_begin[size() - 1]; }
+  [[nodiscard]] const T &back() const { return m_begin[size() - 1]; }
+
+  [[nodiscard]] T *data() noexcept { return m_begin; }
+  [[nodiscard]] const T *data() const noexcept { return m_begin; }
+  /* Element Access */
+
+  /* Capacity */
+  [[nodiscard]] bool is_empty() const noexcept { return size() == 0; }
+  [[nodiscard]] size_type size() const noexcept { return m_header->m_size; }
+  [[nodiscard]] size_type capacity() const noexcept {
+    return m_header->m_capacity;
+  }
+
+  void reserve(size_type count) {
+    if (count > capacity())
+      grow_to(count);
+  }
+
+  // releases file space beyond size()
+  void shrink_to_fit() {
+    if (capacity() > size())
+      grow_to(size());
+  }
+  /* Capacity */
+
+  /* Modifiers */
+  void clear() noexcept { m_header->m_size = 0; }
+
+  void push_back(const T &value) {
+    if (size() == capacity())
+      expand();
+
+    m_begin[m_header->m_size++] = value;
+  }
+
+  template <class... Args> T &emplace_back(Args &&...args) {
+    if (size() == capacity())
+      expand();
+
+    T *const slot =
+        std::construct_at(m_begin + size(), std::forward<Args>(args)...);
+    ++m_header->m_size;
+    return *slot;
+  }
+
+  void pop_back() noexcept { --m_header->m_size; }
+
+  void resize(size_type count) {
+    if (count > capacity())
+      grow_to(count);
+    for (size_type i = size(); i < count; ++i)
+      std::construct_at(m_begin + i);
+
+    m_header->m_size = count;
+  }
+  /* Modifiers */
+
+  /* Persistence */
+  // blocks until elements and header are on disk, or only schedules it
+  void flush(bool wait = true) { m_file.flush(wait); }
+
+  // flushes only the elements in [first, first + count) plus the header
+  void flush_range(size_type first, size_type count, bool wait = true) {
+    m_file.flush(mapped_data_offset + first * value_size, count * value_size,
+                 wait);
+    m_file.flush(0, mapped_data_offset, wait);
+  }
+
+  void prefetch() const noexcept { m_file.prefetch(); }
+  /* Persistence */
+};
+
+/* Read-only, zero-copy view of a file written by MappedVector<T>. The
+ * mapping is PROT_READ, so the view only hands out const access.
+ */
+template <class T> class MappedVectorView {
+  using size_type = std::size_t;
+  static constexpr size_t value_size = sizeof(T);
+
+  static_assert(std::is_trivially_copyable_v<T>,
+                "MappedVector elements are stored as raw bytes");
+  static_assert(alignof(T) <= mapped_data_offset);
+
+  mapped_file m_file;
+  const mapped_header *m_header{nullptr};
+  const T *m_begin{nullptr};
+
+public:
+  /* Special Member Functions */
+  explicit MappedVectorView(const std::filesystem::path &path,
+                            std::uint32_t user_version = 0)
+      : m_file(path, mapped_mode::read_only),
+        m_header(mapped_detail::check_header(
+            m_file, mapped_header::vector_kind, user_version, value_size,
+            alignof(T))),
+        m_begin(reinterpret_cast<const T *>(m_file.data() +
+                                            mapped_data_offset)) {}
+
+  MappedVectorView(const MappedVectorView &) = delete;
+  MappedVectorView &operator=(const MappedVectorView &) = delete;
+  MappedVectorView(MappedVectorView &&other) noexcept = default;
+  MappedVectorView &operator=(MappedVectorView &&other) noexcept = default;
+  ~MappedVectorView() noexcept = default;
+  /* Special Member Functions */
+
+  /* Element Access */
+  [[nodiscard]] const T &at(size_type pos) const {
+    if (pos >= size())
+      throw std::runtime_error("element access beyond bounds in mappedvector");
+
+    return m_begin[pos];
+  }
+
+  [[nodiscard]] const T &operator[](size_type pos) const noexcept {
+    return m_begin[pos];
+  }
+
+  [[nodiscard]] const T &front() const { return m_begin[0]; }
+  [[nodiscard]] const T &back() const { return m_begin[size() - 1]; }
+  [[nodiscard]] const T *data() const noexcept { return m_begin; }
+  /* Element Access */
+
+  /* Capacity */
+  [[nodiscard]] bool is_empty() const noexcept { return size() == 0; }
+  [[nodiscard]] size_type size() const noexcept { return m_header->m_size; }
+  [[nodiscard]] size_type capacity() const noexcept {
+    return m_header->m_capacity;
+  }
+  /* Capacity */
+
+  void prefetch() const noexcept { m_file.prefetch(); }
+};
+
+/* edenlib::Bitset<N> living in a file. bits() refers straight into the
+ * mapping, so all Bitset operations work on the file contents in place.
+ * Always writable, MappedBitsetView reads a file read_only.
+ */
+template <std::size_t N> class MappedBitset {
+  using bitset_type = edenlib::Bitset<N>;
+
+  static_assert(alignof(bitset_type) <= mapped_data_offset);
+
+  mapped_file m_file;
+  bitset_type *m_bits{nullptr};
+
+public:
+  /* Special Member Functions */
+  MappedBitset(const std::filesystem::path &path, mapped_mode mode,
+               std::uint32_t user_version = 0)
+      : m_file(path, mapped_detail::writable_mode(mode, "MappedBitset"),
+               mapped_data_offset + sizeof(bitset_type)) {
+    std::byte *const payload = m_file.data() + mapped_data_offset;
+
+    if (mode == mapped_mode::create) {
+      mapped_header *const header = mapped_detail::init_header(
+          m_file.data(), mapped_header::bitset_kind, user_version,
+          sizeof(typename bitset_type::data_type),
+          alignof(typename bitset_type::data_type));
+      header->m_size = N;
+      header->m_capacity = bitset_type::num_data;
+      m_bits = std::construct_at(reinterpret_cast<bitset_type *>(payload));
+      return;
+    }
+
+    const mapped_header *const header = mapped_detail::check_header(
+        m_file, mapped_header::bitset_kind, user_version,
+        sizeof(typename bitset_type::data_type),
+        alignof(typename bitset_type::data_type));
+    if (header->m_size != N)
+      throw std::runtime_error("mapped bitset holds a different bit count");
+
+    m_bits = std::launder(reinterpret_cast<bitset_type *>(payload));
+  }
+
+  MappedBitset(const MappedBitset &) = delete;
+  MappedBitset &operator=(const MappedBitset &) = delete;
+  MappedBitset(MappedBitset &&other) noexcept = default;
+  MappedBitset &operator=(MappedBitset &&other) noexcept = default;
+  ~MappedBitset() noexcept = default;
+  /* Special Member Functions */
+
+  [[nodiscard]] bitset_type &bits() noexcept { return *m_bits; }
+  [[nodiscard]] const bitset_type &bits() const noexcept { return *m_bits; }
+
+  [[nodiscard]] static constexpr std::size_t size() noexcept { return N; }
+
+  /* Persistence */
+  void flush(bool wait = true) { m_file.flush(wait); }
+  void prefetch() const noexcept { m_file.prefetch(); }
+  /* Persistence */
+};
+
+/* Read-only, zero-copy view of a file written by MappedBitset<N>. */
+template <std::size_t N> class MappedBitsetView {
+  using bitset_type = edenlib::Bitset<N>;
+
+  mapped_file m_file;
+  const bitset_type *m_bits{nullptr};
+
+public:
+  /* Special Member Functions */
+  explicit MappedBitsetView(const std::filesystem::path &path,
+                            std::uint32_t user_version = 0)
+      : m_file(path, mapped_mode::read_only) {
+    const mapped_header *const header = mapped_detail::check_header(
+        m_file, mapped_header::bitset_kind, user_version,
+        sizeof(typename bitset_type::data_type),
+        alignof(typename bitset_type::data_type));
+    if (header->m_size != N)
+      throw std::runtime_error("mapped bitset holds a different bit count");
+
+    m_bits = std::launder(reinterpret_cast<const bitset_type *>(
+        m_file.data() + mapped_data_offset));
+  }
+
+  MappedBitsetView(const MappedBitsetView &) = delete;
+  MappedBitsetView &operator=(const MappedBitsetView &) = delete;
+  MappedBitsetView(MappedBitsetView &&other) noexcept = default;
+  MappedBitsetView &operator=(MappedBitsetView &&other) noexcept = default;
+  ~MappedBitsetView() noexcept = default;
+  /* Special Member Functions */
+
+  [[nodiscard]] const bitset_type &bits() const noexcept { return *m_bits; }
+  [[nodiscard]] static constexpr std::size_t size() noexcept { return N; }
+
+  void prefetch() const noexcept { m_file.prefetch(); }
+};
+
+} // namespace eden
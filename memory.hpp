@@ -1,8 +1,19 @@
+#pragma once
 #include <cstddef>
+#include <cstdint>
 #include <new>
 #include <type_traits>
 
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 namespace eden {
+
+inline constexpr std::size_t cache_line_size = 64;
+
 template <class T> class allocator {
   using value_type = T;
 
@@ -10,6 +21,8 @@ public:
   constexpr allocator() noexcept = default;
   constexpr allocator(const allocator &other) noexcept = default;
   constexpr allocator(allocator &&other) noexcept = default;
+  constexpr allocator &operator=(const allocator &other) noexcept = default;
+  constexpr allocator &operator=(allocator &&other) noexcept = default;
   constexpr ~allocator() noexcept {}
 
   // returns nullptr on allocation failure
@@ -18,7 +31,179 @@ public:
   }
   constexpr void
   deallocate(T *p, std::size_t n) noexcept(std::is_nothrow_destructible_v<T>) {
-    operator delete(p, n);
+    operator delete(p, n * sizeof(T));
+  }
+};
+
+enum class numa_policy {
+  none,       // leave placement to the kernel, usually first touch
+  bind,       // only allocate from m_node
+  preferred,  // prefer m_node, fall back to other nodes
+  interleave, // spread pages round-robin over all nodes
+};
+
+struct huge_page_options {
+  // blocks smaller than this go through operator new as usual
+  std::size_t m_threshold = std::size_t{2} << 20;
+  // try explicit MAP_HUGETLB pages before transparent huge pages
+  bool m_try_hugetlb = true;
+  numa_policy m_numa = numa_policy::none;
+  unsigned m_node = 0;
+};
+
+/* Drop-in Allocator (e.g. for StackVector) for large, long lived blocks.
+ * Blocks of at least m_threshold bytes are mapped directly and rounded up
+ * to whole 2MiB huge pages, which cuts TLB misses on big heaps:
+ * 1. mmap with MAP_HUGETLB for 2MiB pages, which needs pages reserved in
+ *    /sys/kernel/mm/hugepages/hugepages-2048kB/nr_hugepages
+ * 2. otherwise a normal mapping, trimmed to a 2MiB boundary, with
+ *    madvise(MADV_HUGEPAGE), which transparent huge pages honour when enabled
+ * The mapping is then placed on NUMA nodes through mbind, before any page is
+ * touched. Huge pages and NUMA placement are best effort, so on a machine
+ * without them this behaves like allocator<T>. Blocks carry no header:
+ * deallocate tells a mapped block from the size alone, which is why a large
+ * block is never taken from operator new, and a 2MiB request maps exactly
+ * one huge page.
+ */
+template <class T> class huge_page_allocator {
+  using value_type = T;
+
+  static constexpr std::size_t huge_page_size = std::size_t{2} << 20;
+
+  huge_page_options m_options;
+
+#if defined(__linux__)
+  static_assert(alignof(T) <= 4096, "mapped blocks are only page aligned");
+
+  static constexpr std::size_t round_up(std::size_t bytes) noexcept {
+    return (bytes + huge_page_size - 1) / huge_page_size * huge_page_size;
+  }
+
+  void *map(std::size_t bytes) const noexcept {
+    void *memory = MAP_FAILED;
+
+#if defined(MAP_HUGETLB) && defined(MAP_HUGE_SHIFT)
+    // the default huge page size may be 1GiB, and deallocate unmaps in 2MiB
+    // units, so ask for 2MiB pages by size (log2 of it, as MAP_HUGE_2MB)
+    constexpr int map_huge_2mb = 21 << MAP_HUGE_SHIFT;
+    if (m_options.m_try_hugetlb)
+      memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | map_huge_2mb,
+                    -1, 0);
+#endif
+
+    if (memory == MAP_FAILED) {
+      // map one huge page more and trim, so the block is 2MiB aligned and
+      // transparent huge pages can back all of it
+      const std::size_t padded = bytes + huge_page_size;
+      void *const raw = mmap(nullptr, padded, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (raw == MAP_FAILED)
+        return nullptr;
+
+      const auto address = reinterpret_cast<std::uintptr_t>(raw);
+      const std::size_t head =
+          (huge_page_size - address % huge_page_size) % huge_page_size;
+      if (head)
+        munmap(raw, head);
+      if (huge_page_size - head)
+        munmap(static_cast<std::byte *>(raw) + head + bytes,
+               huge_page_size - head);
+      memory = static_cast<std::byte *>(raw) + head;
+
+#if defined(MADV_HUGEPAGE)
+      madvise(memory, bytes, MADV_HUGEPAGE);
+#endif
+    }
+
+    place(memory, bytes);
+    return memory;
+  }
+
+  void place(void *memory, std::size_t bytes) const noexcept {
+#if defined(SYS_mbind)
+    // values from <linux/mempolicy.h>, not pulled in to avoid libnuma
+    constexpr int mpol_preferred = 1;
+    constexpr int mpol_bind = 2;
+    constexpr int mpol_interleave = 3;
+    constexpr unsigned long max_nodes = sizeof(unsigned long) * 8;
+
+    int mode;
+    unsigned long node_mask;
+    switch (m_options.m_numa) {
+    case numa_policy::none:
+      return;
+    case numa_policy::bind:
+    case numa_policy::preferred:
+      if (m_options.m_node >= max_nodes)
+        return;
+      mode = m_options.m_numa == numa_policy::bind ? mpol_bind
+                                                   : mpol_preferred;
+      node_mask = 1ul << m_options.m_node;
+      break;
+    case numa_policy::interleave:
+      mode = mpol_interleave;
+      node_mask = ~0ul;
+      break;
+    default:
+      return;
+    }
+
+    // failure (no NUMA, node offline) just leaves the default policy
+    syscall(SYS_mbind, memory, bytes, mode, &node_mask, max_nodes + 1, 0);
+#else
+    (void)memory;
+    (void)bytes;
+#endif
+  }
+#endif
+
+public:
+  constexpr huge_page_allocator() noexcept = default;
+  explicit constexpr huge_page_allocator(
+      const huge_page_options &options) noexcept
+      : m_options(options) {}
+  constexpr huge_page_allocator(const huge_page_allocator &other) noexcept =
+      default;
+  constexpr huge_page_allocator(huge_page_allocator &&other) noexcept =
+      default;
+  constexpr huge_page_allocator &
+  operator=(const huge_page_allocator &other) noexcept = default;
+  constexpr huge_page_allocator &
+  operator=(huge_page_allocator &&other) noexcept = default;
+  constexpr ~huge_page_allocator() noexcept {}
+
+  [[nodiscard]] constexpr const huge_page_options &options() const noexcept {
+    return m_options;
+  }
+
+  // returns nullptr on allocation failure
+  T *allocate(std::size_t n) noexcept {
+    const std::size_t bytes = n * sizeof(T);
+
+#if defined(__linux__)
+    if (bytes >= m_options.m_threshold)
+      return static_cast<T *>(map(round_up(bytes)));
+#endif
+
+    return static_cast<T *>(operator new(bytes, std::nothrow));
+  }
+
+  void deallocate(T *p, std::size_t n) noexcept {
+    if (!p)
+      return;
+
+    const std::size_t bytes = n * sizeof(T);
+
+#if defined(__linux__)
+    // the size tells how p was obtained, see allocate
+    if (bytes >= m_options.m_threshold) {
+      munmap(p, round_up(bytes));
+      return;
+    }
+#endif
+
+    operator delete(p, bytes);
   }
 };
 
@@ -1,37 +1,363 @@
+#pragma once
 #include "concepts.hpp"
+#include <expected>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define EDEN_ALWAYS_INLINE [[gnu::always_inline]] inline
+#elif defined(_MSC_VER)
+#define EDEN_ALWAYS_INLINE [[msvc::forceinline]] inline
+#else
+#define EDEN_ALWAYS_INLINE inline
+#endif
 
 namespace eden {
-template <class T, class First, class... Remaining>
-constexpr auto
-call_methods_conditionally(T ptr, First first, Remaining... rest) noexcept(
-    noexcept(call_methods_conditionally(first(ptr), rest...)))
-    -> decltype(call_methods_conditionally(first(ptr), rest...))
-  requires pointer_c<decltype(first(ptr))>
-{
-  if (ptr)
-    return call_methods_conditionally(first(ptr), rest...);
-
-  if constexpr (pointer_c<decltype(call_methods_conditionally(first(ptr),
-                                                              rest...))>)
-    return nullptr;
+
+/* Describes how a link in the chain is tested and unwrapped.
+ * has_value: whether the chain may continue
+ * unwrap: what is handed to the next step. Smart pointers hand over the raw
+ *   pointer so shared_ptr links never touch the reference count, optional and
+ *   expected hand over their contained value.
+ * empty: the value returned when the chain stops early
+ */
+template <class T> struct nullable_traits {
+  static constexpr bool is_nullable = false;
+};
+
+template <class T>
+  requires pointer_c<T>
+struct nullable_traits<T> {
+  static constexpr bool is_nullable = true;
+
+  EDEN_ALWAYS_INLINE static constexpr bool has_value(T ptr) noexcept {
+    return ptr != nullptr;
+  }
+  EDEN_ALWAYS_INLINE static constexpr T unwrap(T ptr) noexcept { return ptr; }
+  EDEN_ALWAYS_INLINE static constexpr T empty() noexcept { return nullptr; }
+};
+
+template <class T, class Deleter>
+struct nullable_traits<std::unique_ptr<T, Deleter>> {
+  static constexpr bool is_nullable = true;
+
+  EDEN_ALWAYS_INLINE static constexpr bool
+  has_value(const std::unique_ptr<T, Deleter> &ptr) noexcept {
+    return static_cast<bool>(ptr);
+  }
+  EDEN_ALWAYS_INLINE static constexpr auto
+  unwrap(const std::unique_ptr<T, Deleter> &ptr) noexcept {
+    return ptr.get();
+  }
+  EDEN_ALWAYS_INLINE static constexpr std::unique_ptr<T, Deleter>
+  empty() noexcept {
+    return {};
+  }
+};
+
+template <class T> struct nullable_traits<std::shared_ptr<T>> {
+  static constexpr bool is_nullable = true;
+
+  EDEN_ALWAYS_INLINE static bool
+  has_value(const std::shared_ptr<T> &ptr) noexcept {
+    return static_cast<bool>(ptr);
+  }
+  EDEN_ALWAYS_INLINE static T *unwrap(const std::shared_ptr<T> &ptr) noexcept {
+    return ptr.get();
+  }
+  EDEN_ALWAYS_INLINE static std::shared_ptr<T> empty() noexcept { return {}; }
+};
+
+template <class T> struct nullable_traits<std::optional<T>> {
+  static constexpr bool is_nullable = true;
+
+  EDEN_ALWAYS_INLINE static constexpr bool
+  has_value(const std::optional<T> &opt) noexcept {
+    return opt.has_value();
+  }
+  template <class Opt>
+  EDEN_ALWAYS_INLINE static constexpr decltype(auto)
+  unwrap(Opt &&opt) noexcept {
+    return *std::forward<Opt>(opt);
+  }
+  EDEN_ALWAYS_INLINE static constexpr std::optional<T> empty() noexcept {
+    return std::nullopt;
+  }
+};
+
+// a failed expected has no empty state, its error is carried to the result
+template <class T, class E> struct nullable_traits<std::expected<T, E>> {
+  static constexpr bool is_nullable = true;
+
+  EDEN_ALWAYS_INLINE static constexpr bool
+  has_value(const std::expected<T, E> &exp) noexcept {
+    return exp.has_value();
+  }
+  template <class Exp>
+  EDEN_ALWAYS_INLINE static constexpr decltype(auto)
+  unwrap(Exp &&exp) noexcept {
+    return *std::forward<Exp>(exp);
+  }
+};
+
+template <class T>
+concept nullable_c = nullable_traits<remove_cvref<T>>::is_nullable;
+
+template <class T> struct is_expected_struct {
+  static constexpr bool value = false;
+};
+
+template <class T, class E> struct is_expected_struct<std::expected<T, E>> {
+  static constexpr bool value = true;
+};
+
+template <class T> struct is_smart_pointer_struct {
+  static constexpr bool value = false;
+};
+
+template <class T, class Deleter>
+struct is_smart_pointer_struct<std::unique_ptr<T, Deleter>> {
+  static constexpr bool value = true;
+};
+
+template <class T> struct is_smart_pointer_struct<std::shared_ptr<T>> {
+  static constexpr bool value = true;
+};
+
+template <class Value>
+using chain_unwrapped = decltype(nullable_traits<remove_cvref<Value>>::unwrap(
+    std::declval<Value>()));
+
+template <class Value, class Step>
+using chain_step_result = std::invoke_result_t<Step &, chain_unwrapped<Value>>;
+
+/* What the last step hands back to the caller. Getters often return a
+ * nullable by reference, the result is decayed so the empty path never
+ * returns a reference to a temporary. A smart pointer returned by reference
+ * is handed back as its raw pointer: a unique_ptr cannot be copied, and
+ * copying a shared_ptr would touch its reference count.
+ */
+template <class T> struct chain_last_struct {
+  using type = remove_cvref<T>;
+};
+
+template <class T>
+  requires std::is_lvalue_reference_v<T> &&
+           is_smart_pointer_struct<remove_cvref<T>>::value
+struct chain_last_struct<T> {
+  using type = remove_cvref<chain_unwrapped<T>>;
+};
+
+template <class Value, class... Steps> struct chain_result_struct;
+
+template <class Value, class Last> struct chain_result_struct<Value, Last> {
+  using type = chain_last_struct<chain_step_result<Value, Last>>::type;
+  static_assert(nullable_c<type> || void_c<type>,
+                "the last method in a chain must return a nullable or void");
+};
+
+template <class Value, class First, class... Rest>
+struct chain_result_struct<Value, First, Rest...>
+    : chain_result_struct<chain_step_result<Value, First>, Rest...> {
+  static_assert(nullable_c<chain_step_result<Value, First>>,
+                "every method but the last must return a nullable");
+};
+
+template <class Value, class... Steps>
+using chain_result = chain_result_struct<Value, Steps...>::type;
+
+// whether a chain can throw: a step, or building the result on either path.
+// A result that is unwrapped rather than constructed never throws.
+template <class Result, class Value, class... Steps>
+struct chain_nothrow_struct;
+
+template <class Result, class Value, class Last>
+struct chain_nothrow_struct<Result, Value, Last> {
+  static constexpr bool value =
+      std::is_nothrow_invocable_v<Last &, chain_unwrapped<Value>> &&
+      (void_c<Result> ||
+       ((std::is_nothrow_convertible_v<chain_step_result<Value, Last>,
+                                       Result> ||
+         !std::is_convertible_v<chain_step_result<Value, Last>, Result>) &&
+        std::is_nothrow_move_constructible_v<Result>));
+};
+
+template <class Result, class Value, class First, class... Rest>
+struct chain_nothrow_struct<Result, Value, First, Rest...> {
+  static constexpr bool value =
+      std::is_nothrow_invocable_v<First &, chain_unwrapped<Value>> &&
+      chain_nothrow_struct<Result, chain_step_result<Value, First>,
+                           Rest...>::value;
+};
+
+template <class Value, class... Steps>
+inline constexpr bool chain_nothrow =
+    chain_nothrow_struct<chain_result<Value, Steps...>, Value,
+                         Steps...>::value;
+
+template <class Result, class Value>
+EDEN_ALWAYS_INLINE constexpr Result chain_stop(Value &&failed) {
+  if constexpr (void_c<Result>) {
+    return;
+  } else if constexpr (is_expected_struct<Result>::value) {
+    if constexpr (is_expected_struct<remove_cvref<Value>>::value)
+      return std::unexpected(std::forward<Value>(failed).error());
+    else
+      return Result(std::unexpect);
+  } else {
+    return nullable_traits<Result>::empty();
+  }
+}
+
+template <class Result, class Value, class First, class... Rest>
+EDEN_ALWAYS_INLINE constexpr Result
+call_chain(Value &&value, First &first, Rest &...rest) noexcept(
+    chain_nothrow_struct<Result, Value, First, Rest...>::value) {
+  using traits = nullable_traits<remove_cvref<Value>>;
+
+  if (traits::has_value(value)) [[likely]] {
+    if constexpr (sizeof...(Rest) != 0)
+      return call_chain<Result>(
+          std::invoke(first, traits::unwrap(std::forward<Value>(value))),
+          rest...);
+    else if constexpr (void_c<Result> ||
+                       std::is_convertible_v<chain_step_result<Value, First>,
+                                             Result>)
+      return std::invoke(first, traits::unwrap(std::forward<Value>(value)));
+    else
+      return nullable_traits<remove_cvref<chain_step_result<Value, First>>>::
+          unwrap(std::invoke(first, traits::unwrap(std::forward<Value>(value))));
+  }
+
+  return chain_stop<Result>(std::forward<Value>(value));
+}
+
+/* Chains where every link but the last unwraps to a pointer run as plain
+ * pointer tests, and only the last step builds the result. Returning the
+ * result through every level of call_chain instead makes GCC spill it at
+ * each level. A link is only reduced to its pointer if nothing owned is lost
+ * with it: it is a raw pointer, or it was returned by reference.
+ */
+template <class Link>
+inline constexpr bool chain_pointer_link =
+    !is_expected_struct<remove_cvref<Link>>::value &&
+    pointer_c<remove_cvref<chain_unwrapped<Link>>> &&
+    (pointer_c<remove_cvref<Link>> || std::is_lvalue_reference_v<Link>);
+
+template <class Value, class... Steps> struct chain_pointer_prefix_struct;
+
+template <class Value, class Last>
+struct chain_pointer_prefix_struct<Value, Last> {
+  static constexpr bool value = true;
+};
+
+template <class Value, class First, class... Rest>
+struct chain_pointer_prefix_struct<Value, First, Rest...> {
+  static constexpr bool value =
+      chain_pointer_link<chain_step_result<Value, First>> &&
+      chain_pointer_prefix_struct<chain_step_result<Value, First>,
+                                  Rest...>::value;
+};
+
+// the value itself is alive for the whole call, so only its type matters
+template <class Value, class... Steps>
+inline constexpr bool chain_pointer_prefix =
+    !is_expected_struct<remove_cvref<Value>>::value &&
+    pointer_c<remove_cvref<chain_unwrapped<Value>>> &&
+    chain_pointer_prefix_struct<Value, Steps...>::value;
+
+// the pointer the step after these is called on, nullptr once a link is empty
+template <class Pointer>
+EDEN_ALWAYS_INLINE constexpr Pointer chain_pointer(Pointer ptr) noexcept {
+  return ptr;
+}
+
+template <class Pointer, class First, class... Rest>
+EDEN_ALWAYS_INLINE constexpr auto chain_pointer(Pointer ptr, First &first,
+                                                Rest &...rest) {
+  using link = chain_step_result<Pointer, First>;
+  using traits = nullable_traits<remove_cvref<link>>;
+  using next = remove_cvref<chain_unwrapped<link>>;
+
+  if (!ptr)
+    return chain_pointer(next(nullptr), rest...);
+
+  link step = std::invoke(first, ptr);
+  return chain_pointer(
+      traits::has_value(step) ? next(traits::unwrap(step)) : next(nullptr),
+      rest...);
+}
+
+template <class Result, class Value, class... Steps, std::size_t... Prefix>
+EDEN_ALWAYS_INLINE constexpr Result
+call_pointer_chain(Value &&value, std::index_sequence<Prefix...>,
+                   Steps &...steps) {
+  using traits = nullable_traits<remove_cvref<Value>>;
+  using start = remove_cvref<chain_unwrapped<Value>>;
+
+  auto &&all = std::forward_as_tuple(steps...);
+  auto &last = std::get<sizeof...(Steps) - 1>(all);
+  const auto ptr = chain_pointer(
+      traits::has_value(value) ? start(traits::unwrap(value)) : start(nullptr),
+      std::get<Prefix>(all)...);
+  using last_result = chain_step_result<decltype(ptr), decltype(last)>;
+
+  if (ptr) [[likely]] {
+    if constexpr (void_c<Result> || std::is_convertible_v<last_result, Result>)
+      return std::invoke(last, ptr);
+    else
+      return nullable_traits<remove_cvref<last_result>>::unwrap(
+          std::invoke(last, ptr));
+  }
+
+  return chain_stop<Result>(ptr);
+}
+
+/* Calls each step on the result of the one before, stopping at the first
+ * null pointer, empty smart pointer, empty optional or failed expected.
+ * Steps other than the last must return one of those; the last may also
+ * return void, and its result is returned by value. On an early stop the
+ * result is empty (nullptr, nullopt...) or, for expected, the error of the
+ * link that failed (a value-initialised error if that link was not an
+ * expected).
+ *
+ * Everything is forced inline, so a chain compiles to the same branches as
+ * the nested ifs it replaces.
+ */
+template <class Value, class... Steps>
+  requires nullable_c<Value> && (sizeof...(Steps) > 0)
+EDEN_ALWAYS_INLINE constexpr chain_result<Value, Steps...>
+call_methods_conditionally(Value &&value, Steps... steps) noexcept(
+    chain_nothrow<Value, Steps...>) {
+  if constexpr (chain_pointer_prefix<Value, Steps...>)
+    return call_pointer_chain<chain_result<Value, Steps...>>(
+        std::forward<Value>(value),
+        std::make_index_sequence<sizeof...(Steps) - 1>{}, steps...);
+  else
+    return call_chain<chain_result<Value, Steps...>>(
+        std::forward<Value>(value), steps...);
 }
 
-template <class T, class Last>
-constexpr auto
-call_methods_conditionally(T ptr, Last last) noexcept(noexcept(last(ptr)))
-    -> decltype(last(ptr))
-  requires pointer_c<decltype(last(ptr))> || void_c<decltype(last(ptr))>
-{
-  if (ptr)
-    return last(ptr);
-
-  if constexpr (pointer_c<decltype(last(ptr))>)
-    return nullptr;
+// object to call a member on, whether the link unwrapped to a pointer or not
+template <class T>
+EDEN_ALWAYS_INLINE constexpr decltype(auto) chain_deref(T &&link) noexcept {
+  if constexpr (pointer_c<remove_cvref<T>>)
+    return *link;
+  else
+    return std::forward<T>(link);
 }
 
 #define next_method(method_name, ...)                                          \
-  [&]<class T>(T ptr) constexpr noexcept(noexcept((ptr->*&method_name)(        \
-      __VA_ARGS__))) { return (ptr->*&method_name)(__VA_ARGS__); }
+  [&]<class T>(T &&link) constexpr noexcept(                                   \
+      noexcept((eden::chain_deref(std::forward<T>(link)).*&method_name)(       \
+          __VA_ARGS__))) -> decltype(auto) {                                   \
+    return (eden::chain_deref(std::forward<T>(link)).*&method_name)(           \
+        __VA_ARGS__);                                                          \
+  }
 
 // use as such:
 // call_methods_conditionally(init_ptr, next_method(T::first, args),
@@ -0,0 +1,303 @@
+#pragma once
+#include "bitset.hpp"
+#include "stack_vector.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+namespace eden {
+
+/* Parallel algorithms over StackVector and Bitset, built on
+ * thread_pool::parallel_for.
+ *
+ * A StackVector is two contiguous segments (the inline buffer and the heap
+ * block), so work is cut into chunks per segment and never straddles the
+ * boundary. Chunk sizes are whole cache lines of elements, and when a line
+ * holds a whole number of elements the chunk edges are put on line
+ * boundaries of the actual addresses, so two workers never write the same
+ * line. Neither segment is itself line aligned, which makes the first chunk
+ * of each a little short.
+ */
+namespace parallel_detail {
+
+// smallest chunk worth handing to another thread
+inline constexpr std::size_t min_chunk_bytes = 4096;
+// chunks per worker, leaves room for stealing to even out the load
+inline constexpr std::size_t chunks_per_worker = 8;
+
+template <class T>
+constexpr std::size_t elements_per_line =
+    sizeof(T) >= cache_line_size ? 1 : cache_line_size / sizeof(T);
+
+template <class T>
+constexpr std::size_t default_grain(const thread_pool &pool,
+                                    std::size_t count) noexcept {
+  constexpr std::size_t per_line = elements_per_line<T>;
+  constexpr std::size_t min_grain =
+      std::max<std::size_t>(min_chunk_bytes / sizeof(T), 1);
+
+  const std::size_t target_chunks = pool.size() * chunks_per_worker;
+  std::size_t grain = std::max(count / target_chunks + 1, min_grain);
+  return (grain + per_line - 1) / per_line * per_line;
+}
+
+template <class T> struct segment {
+  T *m_data;
+  std::size_t m_count;
+  std::size_t m_first_index;
+  // elements that would fit between the start of m_data[0]'s cache line and
+  // m_data[0], chunk c starts at c * grain - m_skew
+  std::size_t m_skew{0};
+};
+
+template <class T> std::size_t line_skew(const T *data) noexcept {
+  if constexpr (cache_line_size % sizeof(T) != 0) {
+    return 0;
+  } else {
+    const std::size_t offset =
+        reinterpret_cast<std::uintptr_t>(data) % cache_line_size;
+    return offset % sizeof(T) ? 0 : offset / sizeof(T);
+  }
+}
+
+template <class Vector> constexpr auto segments_of(Vector &vec) noexcept {
+  using value_type = std::remove_pointer_t<decltype(vec.stack_data())>;
+
+  const std::size_t size = vec.size();
+  const std::size_t on_stack = std::min(size, vec.stack_capacity());
+  return std::array<segment<value_type>, 2>{
+      segment<value_type>{vec.stack_data(), on_stack, 0,
+                          line_skew(vec.stack_data())},
+      segment<value_type>{vec.heap_data(), size - on_stack, on_stack,
+                          line_skew(vec.heap_data())}};
+}
+
+template <class T> struct chunk_plan {
+  std::array<segment<T>, 2> m_segments;
+  std::size_t m_grain;
+  std::size_t m_stack_chunks;
+  std::size_t m_total_chunks;
+};
+
+template <class Vector>
+auto make_chunk_plan(const thread_pool &pool, Vector &vec) noexcept {
+  using value_type = std::remove_pointer_t<decltype(vec.stack_data())>;
+
+  chunk_plan<value_type> plan{segments_of(vec),
+                              default_grain<value_type>(pool, vec.size()), 0,
+                              0};
+  const auto chunks_in = [&plan](const segment<value_type> &seg) {
+    return seg.m_count ? (seg.m_skew + seg.m_count - 1) / plan.m_grain + 1
+                       : 0;
+  };
+  plan.m_stack_chunks = chunks_in(plan.m_segments[0]);
+  plan.m_total_chunks = plan.m_stack_chunks + chunks_in(plan.m_segments[1]);
+  return plan;
+}
+
+/* Calls visit(data, count, first_index, chunk) over the chunks of plan, in
+ * parallel.
+ */
+template <class T, class Visitor>
+void for_each_chunk(thread_pool &pool, const chunk_plan<T> &plan,
+                    Visitor &&visit) {
+  pool.parallel_for(
+      plan.m_total_chunks, 1, [&](std::size_t first, std::size_t last) {
+        for (std::size_t chunk = first; chunk < last; ++chunk) {
+          const bool on_heap = chunk >= plan.m_stack_chunks;
+          const segment<T> &seg = plan.m_segments[on_heap];
+          const std::size_t local =
+              on_heap ? chunk - plan.m_stack_chunks : chunk;
+          // the grain is a whole number of lines, so more than the skew
+          const std::size_t offset =
+              std::max(local * plan.m_grain, seg.m_skew) - seg.m_skew;
+          const std::size_t end = std::min(
+              (local + 1) * plan.m_grain - seg.m_skew, seg.m_count);
+          visit(seg.m_data + offset, end - offset, seg.m_first_index + offset,
+                chunk);
+        }
+      });
+}
+
+template <class T> struct alignas(cache_line_size) padded_partial {
+  std::optional<T> m_value;
+};
+
+template <std::size_t N>
+constexpr typename edenlib::Bitset<N>::data_type
+masked_word(const edenlib::Bitset<N> &set, std::size_t word) noexcept {
+  using Set = edenlib::Bitset<N>;
+  constexpr std::size_t tail_bits = N % Set::bitsofType;
+
+  if (tail_bits != 0 && word == Set::num_data - 1)
+    return set.bits[word] & ((typename Set::data_type{1} << tail_bits) - 1);
+
+  return set.bits[word];
+}
+
+template <std::size_t N>
+constexpr std::size_t words_per_chunk(const thread_pool &pool) noexcept {
+  using Set = edenlib::Bitset<N>;
+  return default_grain<typename Set::data_type>(pool, Set::num_data);
+}
+
+} // namespace parallel_detail
+
+/* StackVector */
+template <class T, std::size_t S, class A, class Function>
+void parallel_for_each(thread_pool &pool, StackVector<T, S, A> &vec,
+                       Function func) {
+  parallel_detail::for_each_chunk(
+      pool, parallel_detail::make_chunk_plan(pool, vec),
+      [&func](T *data, std::size_t count, std::size_t, std::size_t) {
+        for (std::size_t i{}; i < count; ++i)
+          std::invoke(func, data[i]);
+      });
+}
+
+// out must already hold as many elements as in
+template <class T, std::size_t S, class A, class U, std::size_t OutS,
+          class OutA, class Function>
+void parallel_transform(thread_pool &pool, const StackVector<T, S, A> &in,
+                        StackVector<U, OutS, OutA> &out, Function func) {
+  if (out.size() != in.size())
+    throw std::runtime_error("size mismatch in parallel_transform");
+
+  // chunks follow the layout of out, the vector being written
+  parallel_detail::for_each_chunk(
+      pool, parallel_detail::make_chunk_plan(pool, out),
+      [&func, &in](U *data, std::size_t count, std::size_t first,
+                   std::size_t) {
+        for (std::size_t i{}; i < count; ++i) {
+          const std::size_t pos = first + i;
+          data[i] = std::invoke(func, pos < S ? in.stack_data()[pos]
+                                              : in.heap_data()[pos - S]);
+        }
+      });
+}
+
+// op must be associative, partial results are combined in index order
+template <class T, std::size_t S, class A, class Init,
+          class BinaryOp = std::plus<>>
+Init parallel_reduce(thread_pool &pool, const StackVector<T, S, A> &vec,
+                     Init init, BinaryOp op = {}) {
+  const auto plan = parallel_detail::make_chunk_plan(pool, vec);
+  std::vector<parallel_detail::padded_partial<Init>> partials(
+      plan.m_total_chunks);
+
+  parallel_detail::for_each_chunk(
+      pool, plan,
+      [&](const T *data, std::size_t count, std::size_t, std::size_t chunk) {
+        Init acc = static_cast<Init>(data[0]);
+        for (std::size_t i{1}; i < count; ++i)
+          acc = std::invoke(op, std::move(acc), data[i]);
+
+        partials[chunk].m_value.emplace(std::move(acc));
+      });
+
+  for (auto &partial : partials)
+    init = std::invoke(op, std::move(init), std::move(*partial.m_value));
+
+  return init;
+}
+
+/* Sorts the contiguous range [first, last): chunks are sorted in parallel,
+ * then merged pairwise in rounds. The final rounds have few merges, so this
+ * scales best when the chunk sort dominates.
+ */
+template <class T, class Compare = std::less<>>
+void parallel_sort(thread_pool &pool, T *first, T *last, Compare comp = {}) {
+  const std::size_t count = last - first;
+  const std::size_t grain = parallel_detail::default_grain<T>(pool, count);
+
+  pool.parallel_for(count, grain, [&](std::size_t begin, std::size_t end) {
+    std::sort(first + begin, first + end, comp);
+  });
+
+  for (std::size_t width = grain; width < count; width *= 2) {
+    const std::size_t merges = (count - 1) / (2 * width) + 1;
+    pool.parallel_for(merges, 1, [&](std::size_t begin, std::size_t end) {
+      for (std::size_t m = begin; m < end; ++m) {
+        const std::size_t lo = m * 2 * width;
+        const std::size_t mid = std::min(lo + width, count);
+        const std::size_t hi = std::min(lo + 2 * width, count);
+        if (mid < hi)
+          std::inplace_merge(first + lo, first + mid, first + hi, comp);
+      }
+    });
+  }
+}
+
+template <class T, std::size_t S, class A, class Compare = std::less<>>
+void parallel_sort(thread_pool &pool, StackVector<T, S, A> &vec,
+                   Compare comp = {}) {
+  auto segments = parallel_detail::segments_of(vec);
+  for (auto &seg : segments)
+    parallel_sort(pool, seg.m_data, seg.m_data + seg.m_count, comp);
+
+  if (segments[1].m_count == 0)
+    return;
+
+  // the two sorted segments are not adjacent in memory, merge through a copy
+  std::vector<T> merged;
+  merged.reserve(vec.size());
+  std::merge(std::make_move_iterator(segments[0].m_data),
+             std::make_move_iterator(segments[0].m_data + segments[0].m_count),
+             std::make_move_iterator(segments[1].m_data),
+             std::make_move_iterator(segments[1].m_data + segments[1].m_count),
+             std::back_inserter(merged), comp);
+
+  parallel_detail::for_each_chunk(
+      pool, parallel_detail::make_chunk_plan(pool, vec),
+      [&merged](T *data, std::size_t count, std::size_t first, std::size_t) {
+        std::move(merged.begin() + first, merged.begin() + first + count, data);
+      });
+}
+/* StackVector */
+
+/* Bitset */
+template <std::size_t N>
+std::size_t parallel_count(thread_pool &pool, const edenlib::Bitset<N> &set) {
+  std::atomic<std::size_t> total{0};
+
+  pool.parallel_for(
+      edenlib::Bitset<N>::num_data, parallel_detail::words_per_chunk<N>(pool),
+      [&](std::size_t first, std::size_t last) {
+        std::size_t local{};
+        for (std::size_t w = first; w < last; ++w)
+          local += std::popcount(parallel_detail::masked_word(set, w));
+        total.fetch_add(local, std::memory_order_relaxed);
+      });
+
+  return total.load(std::memory_order_relaxed);
+}
+
+// func(pos) is called concurrently, in no particular order across chunks
+template <std::size_t N, class Function>
+void parallel_for_each_set_bit(thread_pool &pool,
+                               const edenlib::Bitset<N> &set, Function func) {
+  using Set = edenlib::Bitset<N>;
+
+  pool.parallel_for(
+      Set::num_data, parallel_detail::words_per_chunk<N>(pool),
+      [&](std::size_t first, std::size_t last) {
+        for (std::size_t w = first; w < last; ++w) {
+          auto word = parallel_detail::masked_word(set, w);
+          while (word) {
+            std::invoke(func, w * Set::bitsofType + std::countr_zero(word));
+            word &= word - 1;
+          }
+        }
+      });
+}
+/* Bitset */
+
+} // namespace eden
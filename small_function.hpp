@@ -0,0 +1,307 @@
+#pragma once
+#include "memory.hpp"
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+namespace eden {
+
+template <bool Copyable, class Signature, std::size_t InlineBytes,
+          class Allocator>
+class BasicSmallFunction;
+
+/* Callables that fit in InlineBytes (and are nothrow movable) are stored in
+ * the inline buffer, the same way StackVector keeps its first elements in
+ * m_stack_buffer. Anything bigger is placed in memory from Allocator and only
+ * the pointer lives in the buffer.
+ *
+ * Dispatch goes through two plain function pointers held in the object
+ * itself: m_invoke for calls and m_manage for move/copy/destroy. There is no
+ * vtable object to load first, so a call is a single indirect jump.
+ *
+ * To Do:
+ *
+ * Add const/noexcept qualified signatures
+ */
+template <bool Copyable, class R, class... Args, std::size_t InlineBytes,
+          class Allocator>
+class BasicSmallFunction<Copyable, R(Args...), InlineBytes, Allocator> {
+  static_assert(InlineBytes >= sizeof(void *),
+                "inline buffer must be able to hold a heap pointer");
+
+  enum class operation { move, copy, destroy };
+
+  using invoke_fn = R (*)(std::byte *, Args &&...);
+  using manage_fn = void (*)(operation, BasicSmallFunction *dst,
+                             BasicSmallFunction *src);
+
+  template <class F>
+  static constexpr bool stored_inline =
+      sizeof(F) <= InlineBytes && alignof(F) <= alignof(std::max_align_t) &&
+      std::is_nothrow_move_constructible_v<F>;
+
+  [[no_unique_address]] Allocator m_alloc;
+  invoke_fn m_invoke{&invoke_empty};
+  manage_fn m_manage{nullptr};
+  alignas(std::max_align_t) mutable std::byte m_inline_buffer[InlineBytes];
+
+  static R invoke_empty(std::byte *, Args &&...) {
+    throw std::bad_function_call();
+  }
+
+  template <class F> static F *inline_target(std::byte *buffer) noexcept {
+    return std::launder(reinterpret_cast<F *>(buffer));
+  }
+
+  template <class F> static F *&heap_target(std::byte *buffer) noexcept {
+    return *std::launder(reinterpret_cast<F **>(buffer));
+  }
+
+  template <class F>
+  static R invoke_inline(std::byte *buffer, Args &&...args) {
+    return std::invoke_r<R>(*inline_target<F>(buffer),
+                            std::forward<Args>(args)...);
+  }
+
+  template <class F> static R invoke_heap(std::byte *buffer, Args &&...args) {
+    return std::invoke_r<R>(*heap_target<F>(buffer),
+                            std::forward<Args>(args)...);
+  }
+
+  template <class F>
+  static void manage_inline(operation op, BasicSmallFunction *dst,
+                            BasicSmallFunction *src) {
+    switch (op) {
+    case operation::move:
+      std::construct_at(reinterpret_cast<F *>(dst->m_inline_buffer),
+                        std::move(*inline_target<F>(src->m_inline_buffer)));
+      std::destroy_at(inline_target<F>(src->m_inline_buffer));
+      return;
+    case operation::copy:
+      if constexpr (Copyable)
+        std::construct_at(reinterpret_cast<F *>(dst->m_inline_buffer),
+                          *inline_target<F>(src->m_inline_buffer));
+      return;
+    case operation::destroy:
+      std::destroy_at(inline_target<F>(dst->m_inline_buffer));
+      return;
+    }
+  }
+
+  template <class F>
+  static void manage_heap(operation op, BasicSmallFunction *dst,
+                          BasicSmallFunction *src) {
+    switch (op) {
+    case operation::move:
+      ::new (static_cast<void *>(dst->m_inline_buffer))
+          F *(heap_target<F>(src->m_inline_buffer));
+      return;
+    case operation::copy:
+      if constexpr (Copyable)
+        ::new (static_cast<void *>(dst->m_inline_buffer))
+            F *(dst->template allocate_target<F>(
+                *heap_target<F>(src->m_inline_buffer)));
+      return;
+    case operation::destroy: {
+      F *const target = heap_target<F>(dst->m_inline_buffer);
+      std::destroy_at(target);
+      dst->m_alloc.deallocate(reinterpret_cast<std::byte *>(target),
+                              sizeof(F));
+      return;
+    }
+    }
+  }
+
+  template <class F, class... CtorArgs>
+  F *allocate_target(CtorArgs &&...ctor_args) {
+    static_assert(alignof(F) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__,
+                  "over-aligned callables are not supported on the heap path");
+
+    std::byte *const memory = m_alloc.allocate(sizeof(F));
+    if (!memory)
+      throw std::bad_alloc();
+
+    try {
+      return std::construct_at(reinterpret_cast<F *>(memory),
+                               std::forward<CtorArgs>(ctor_args)...);
+    } catch (...) {
+      m_alloc.deallocate(memory, sizeof(F));
+      throw;
+    }
+  }
+
+  template <class F> void store(F &&callable) {
+    using Stored = std::decay_t<F>;
+
+    if constexpr (stored_inline<Stored>) {
+      std::construct_at(reinterpret_cast<Stored *>(m_inline_buffer),
+                        std::forward<F>(callable));
+      m_invoke = &invoke_inline<Stored>;
+      m_manage = &manage_inline<Stored>;
+    } else {
+      ::new (static_cast<void *>(m_inline_buffer))
+          Stored *(allocate_target<Stored>(std::forward<F>(callable)));
+      m_invoke = &invoke_heap<Stored>;
+      m_manage = &manage_heap<Stored>;
+    }
+  }
+
+  void reset() noexcept {
+    if (m_manage)
+      m_manage(operation::destroy, this, nullptr);
+
+    m_invoke = &invoke_empty;
+    m_manage = nullptr;
+  }
+
+  void take(BasicSmallFunction &other) noexcept {
+    if (!other.m_manage)
+      return;
+
+    other.m_manage(operation::move, this, &other);
+    m_invoke = other.m_invoke;
+    m_manage = other.m_manage;
+    other.m_invoke = &invoke_empty;
+    other.m_manage = nullptr;
+  }
+
+  template <class F>
+  static constexpr bool accepts_callable =
+      !std::is_same_v<std::remove_cvref_t<F>, BasicSmallFunction> &&
+      std::is_invocable_r_v<R, std::decay_t<F> &, Args...> &&
+      (!Copyable || std::is_copy_constructible_v<std::decay_t<F>>);
+
+public:
+  using result_type = R;
+
+  /* Special Member Functions */
+  constexpr BasicSmallFunction() noexcept(noexcept(Allocator()))
+      : BasicSmallFunction(Allocator()) {}
+
+  explicit constexpr BasicSmallFunction(const Allocator &alloc) noexcept
+      : m_alloc(alloc) {}
+
+  constexpr BasicSmallFunction(std::nullptr_t) noexcept(noexcept(Allocator()))
+      : BasicSmallFunction() {}
+
+  template <class F>
+    requires accepts_callable<F>
+  BasicSmallFunction(F &&callable, const Allocator &alloc = Allocator())
+      : m_alloc(alloc) {
+    if constexpr (std::is_pointer_v<std::decay_t<F>> ||
+                  std::is_member_pointer_v<std::decay_t<F>>)
+      if (!callable)
+        return;
+
+    store(std::forward<F>(callable));
+  }
+
+  BasicSmallFunction(const BasicSmallFunction &other)
+    requires Copyable
+      : m_alloc(other.m_alloc) {
+    if (!other.m_manage)
+      return;
+
+    other.m_manage(operation::copy, this,
+                   const_cast<BasicSmallFunction *>(&other));
+    m_invoke = other.m_invoke;
+    m_manage = other.m_manage;
+  }
+
+  BasicSmallFunction(BasicSmallFunction &&other) noexcept
+      : m_alloc(std::move_if_noexcept(other.m_alloc)) {
+    take(other);
+  }
+
+  ~BasicSmallFunction() noexcept { reset(); }
+
+  BasicSmallFunction &operator=(const BasicSmallFunction &other)
+    requires Copyable
+  {
+    if (this != &other) {
+      BasicSmallFunction copy(other);
+      reset();
+      m_alloc = copy.m_alloc;
+      take(copy);
+    }
+
+    return *this;
+  }
+
+  BasicSmallFunction &operator=(BasicSmallFunction &&other) noexcept {
+    if (this != &other) {
+      reset();
+      m_alloc = std::move_if_noexcept(other.m_alloc);
+      take(other);
+    }
+
+    return *this;
+  }
+
+  BasicSmallFunction &operator=(std::nullptr_t) noexcept {
+    reset();
+    return *this;
+  }
+
+  template <class F>
+    requires accepts_callable<F>
+  BasicSmallFunction &operator=(F &&callable) {
+    BasicSmallFunction replacement(std::forward<F>(callable), m_alloc);
+    reset();
+    take(replacement);
+    return *this;
+  }
+  /* Special Member Functions */
+
+  /* Invocation */
+  R operator()(Args... args) const {
+    return m_invoke(m_inline_buffer, std::forward<Args>(args)...);
+  }
+
+  [[nodiscard]] explicit operator bool() const noexcept {
+    return m_manage != nullptr;
+  }
+
+  [[nodiscard]] bool is_empty() const noexcept { return m_manage == nullptr; }
+  /* Invocation */
+
+  /* Capacity */
+  static constexpr std::size_t inline_capacity() noexcept {
+    return InlineBytes;
+  }
+
+  // true if a callable of type F would be stored without allocating
+  template <class F>
+  [[nodiscard]] static constexpr bool fits_inline() noexcept {
+    return stored_inline<std::decay_t<F>>;
+  }
+  /* Capacity */
+
+  void swap(BasicSmallFunction &other) noexcept {
+    BasicSmallFunction temp(std::move(other));
+    other = std::move(*this);
+    *this = std::move(temp);
+  }
+
+  friend bool operator==(const BasicSmallFunction &func,
+                         std::nullptr_t) noexcept {
+    return func.is_empty();
+  }
+};
+
+// copyable drop-in for std::function that never allocates for captures of up
+// to InlineBytes
+template <class Signature, std::size_t InlineBytes = 4 * sizeof(void *),
+          class Allocator = allocator<std::byte>>
+using SmallFunction =
+    BasicSmallFunction<true, Signature, InlineBytes, Allocator>;
+
+// move-only counterpart, analogous to std::move_only_function
+template <class Signature, std::size_t InlineBytes = 4 * sizeof(void *),
+          class Allocator = allocator<std::byte>>
+using MoveOnlySmallFunction =
+    BasicSmallFunction<false, Signature, InlineBytes, Allocator>;
+
+} // namespace eden
@@ -114,7 +114,7 @@ class StackVector {
   }
 
   constexpr void expand() noexcept(std::is_nothrow_move_constructible_v<T> &&
-                                   noexcept(Allocator::allocate)) {
+                                   noexcept(std::declval<Allocator &>().allocate(1))) {
     const size_type old_size =
         m_begin_heap ? m_heap_capacity_end - m_begin_heap : 1;
 
@@ -271,6 +271,9 @@ public:
 
     return StackBufferSize + (m_heap_capacity_end - m_begin_heap);
   }
+  [[nodiscard]] static constexpr size_type stack_capacity() noexcept {
+    return StackBufferSize;
+  }
   /* Capacity */
 
   /* Modifiers */
@@ -0,0 +1,107 @@
+// Each chained_* function must compile to no more instructions than the
+// nested_* function written by hand next to it, see chain_codegen.sh. A
+// "// known-failure <function>" line records a gap that is not fixed yet.
+#include "../null_conditional_chaining.hpp"
+#include <expected>
+#include <memory>
+#include <optional>
+
+struct Leaf {
+  int m_value;
+  int value() const noexcept { return m_value; }
+  std::optional<int> maybe() const noexcept {
+    return m_value ? std::optional<int>(m_value) : std::nullopt;
+  }
+};
+
+struct Mid {
+  Leaf *m_leaf;
+  std::unique_ptr<Leaf> m_owned;
+  std::shared_ptr<Leaf> m_shared;
+  Leaf *leaf() const noexcept { return m_leaf; }
+  const std::unique_ptr<Leaf> &owned() const noexcept { return m_owned; }
+  const std::shared_ptr<Leaf> &shared() const noexcept { return m_shared; }
+  std::expected<Leaf *, int> checked() const noexcept {
+    if (m_leaf)
+      return m_leaf;
+    return std::unexpected(1);
+  }
+};
+
+struct Root {
+  Mid *m_mid;
+  Mid *mid() const noexcept { return m_mid; }
+};
+
+#define EXPORT extern "C" [[gnu::noinline]]
+
+EXPORT Leaf *chained_pointer(Root *root) {
+  return eden::call_methods_conditionally(root, next_method(Root::mid),
+                                          next_method(Mid::leaf));
+}
+
+EXPORT Leaf *nested_pointer(Root *root) {
+  if (root)
+    if (Mid *mid = root->mid())
+      return mid->leaf();
+  return nullptr;
+}
+
+EXPORT Leaf *chained_unique(Root *root) {
+  return eden::call_methods_conditionally(root, next_method(Root::mid),
+                                          next_method(Mid::owned));
+}
+
+EXPORT Leaf *nested_unique(Root *root) {
+  if (root)
+    if (Mid *mid = root->mid())
+      return mid->owned().get();
+  return nullptr;
+}
+
+// Same tests and branches as the nested ifs, but GCC 12 gives the empty
+// path its own copy of the code that packs the optional into a register,
+// where the nested version shares one.
+// known-failure chained_shared
+EXPORT std::optional<int> chained_shared(Root *root) {
+  return eden::call_methods_conditionally(root, next_method(Root::mid),
+                                          next_method(Mid::shared),
+                                          next_method(Leaf::maybe));
+}
+
+EXPORT std::optional<int> nested_shared(Root *root) {
+  if (root)
+    if (Mid *mid = root->mid())
+      if (Leaf *leaf = mid->shared().get())
+        return leaf->maybe();
+  return std::nullopt;
+}
+
+EXPORT std::expected<int, int> chained_expected(Mid *mid) {
+  return eden::call_methods_conditionally(
+      mid->checked(), [](Leaf *leaf) noexcept -> std::expected<int, int> {
+        return leaf->value();
+      });
+}
+
+EXPORT std::expected<int, int> nested_expected(Mid *mid) {
+  const std::expected<Leaf *, int> leaf = mid->checked();
+  if (leaf)
+    return (*leaf)->value();
+  return std::unexpected(leaf.error());
+}
+
+// a shared_ptr returned by reference comes back as its raw pointer, a copy
+// would touch the reference count
+EXPORT void check_shared_result(Root *root) {
+  static_assert(std::is_same_v<decltype(eden::call_methods_conditionally(
+                                   root, next_method(Root::mid),
+                                   next_method(Mid::shared))),
+                               Leaf *>);
+}
+
+// noexcept is carried over from the steps
+EXPORT void check_noexcept(Root *root) {
+  static_assert(noexcept(eden::call_methods_conditionally(
+      root, next_method(Root::mid), next_method(Mid::leaf))));
+}
@@ -0,0 +1,48 @@
+#!/usr/bin/env bash
+# Disassembly regression test for null_conditional_chaining.hpp: compiles
+# chain_codegen.cpp and checks every chained_* function has at most as many
+# instructions as its hand-written nested_* counterpart. Functions marked as
+# known failures in the source are reported but do not fail the run, unless
+# they pass, so the mark is removed once the gap is closed.
+#
+#   CXX=g++ test/chain_codegen.sh [extra flags]
+#
+# Needs GCC 13 or clang 17 at least, for static_assert(false) in
+# type_traits.hpp (P2593).
+set -euo pipefail
+
+CXX=${CXX:-c++}
+DIR=$(cd "$(dirname "$0")" && pwd)
+ASM=$(mktemp)
+trap 'rm -f "$ASM"' EXIT
+
+"$CXX" -std=c++23 -O2 -S -fno-asynchronous-unwind-tables -o "$ASM" "$@" \
+  "$DIR/chain_codegen.cpp"
+
+# instructions between a function's label and its .size directive
+count() {
+  awk -v fn="$1" '
+    $0 == fn ":" { inside = 1; next }
+    inside && $1 == ".size" { exit }
+    inside && /^\t[a-z]/ { ++n }
+    END { print n + 0 }' "$ASM"
+}
+
+status=0
+for chained in $(grep -o '^chained_[a-z_]*:' "$ASM" | tr -d ':'); do
+  nested=nested_${chained#chained_}
+  have=$(count "$chained")
+  want=$(count "$nested")
+  known=$(awk -v fn="$chained" '$2 == "known-failure" && $3 == fn' \
+    "$DIR/chain_codegen.cpp")
+  if [ "$have" -le "$want" ] && [ "$have" -gt 0 ]; then
+    result=ok
+    [ -z "$known" ] || { result=XPASS; status=1; }
+  else
+    result=FAIL
+    if [ -n "$known" ]; then result=xfail; else status=1; fi
+  fi
+  printf '%-6s%s: %s instructions, hand-written %s\n' \
+    "$result" "$chained" "$have" "$want"
+done
+exit $status
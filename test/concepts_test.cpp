@@ -0,0 +1,103 @@
+// The traits and concepts must give the standard's answer for every type,
+// with the compiler builtins and without them, so EDEN_NO_BUILTIN_TRAITS
+// never changes overload resolution. Compile-only, in both modes:
+//
+//   c++ -std=c++23 -fsyntax-only test/concepts_test.cpp
+//   c++ -std=c++23 -fsyntax-only -DEDEN_NO_BUILTIN_TRAITS test/concepts_test.cpp
+//
+// Needs GCC 13 or clang 17 at least, for static_assert(false) in
+// type_traits.hpp (P2593).
+#include "../concepts.hpp"
+#include <cstddef>
+#include <type_traits>
+
+namespace {
+
+struct Class {
+  int m_member;
+  void method();
+};
+union Union {
+  int m_int;
+  float m_float;
+};
+enum Enum { enumerator };
+enum class ScopedEnum { enumerator };
+using Lambda = decltype([] {});
+
+template <class... T> struct type_list {};
+
+using types = type_list<
+    // fundamental
+    void, const void, volatile void, const volatile void, bool, char,
+    signed char, unsigned char, wchar_t, char8_t, char16_t, char32_t, short,
+    unsigned short, int, const int, volatile int, unsigned, long,
+    unsigned long, long long, const unsigned long long, float, const double,
+    long double, std::nullptr_t, const std::nullptr_t,
+    // pointers and references
+    int *, const int *, int *const, void *, const volatile void *volatile,
+    int **, Class *, int (*)(), int (*)[3], int &, const int &, int &&,
+    int *&, int (&)(), int (&)[3], std::nullptr_t &,
+    // arrays
+    int[3], const int[3], int[], const volatile int[], int[2][3], Class[4],
+    // functions
+    int(), void(int, ...), int() const, int() &&, void() noexcept,
+    // member pointers
+    int Class::*, int Class::*const, void (Class::*)(),
+    void (Class::*const volatile)(), int Class::*&,
+    // classes, unions and enums
+    Class, const Class, volatile Class, Union, const Union, Enum, const Enum,
+    ScopedEnum, Lambda>;
+
+template <class... T>
+constexpr bool all_agree(type_list<T...>, auto agrees) noexcept {
+  return (agrees.template operator()<T>() && ...);
+}
+
+#define AGREES(concept_name, trait)                                            \
+  static_assert(all_agree(types{},                                             \
+                          []<class T>() {                                      \
+                            return concept_name<T> == trait<T>;                \
+                          }),                                                  \
+                #concept_name " differs from " #trait)
+
+#define SAME_TYPE(alias, std_alias)                                            \
+  static_assert(all_agree(types{},                                             \
+                          []<class T>() {                                      \
+                            return std::is_same_v<alias<T>, std_alias<T>>;     \
+                          }),                                                  \
+                #alias " differs from " #std_alias)
+
+AGREES(eden::void_c, std::is_void_v);
+AGREES(eden::null_pointer_c, std::is_null_pointer_v);
+AGREES(eden::integral_c, std::is_integral_v);
+AGREES(eden::floating_point_c, std::is_floating_point_v);
+AGREES(eden::arithmetic_c, std::is_arithmetic_v);
+AGREES(eden::fundamental_c, std::is_fundamental_v);
+AGREES(eden::pointer_c, std::is_pointer_v);
+AGREES(eden::member_pointer_c, std::is_member_pointer_v);
+AGREES(eden::array_c, std::is_array_v);
+AGREES(eden::lvalue_ref_c, std::is_lvalue_reference_v);
+AGREES(eden::rvalue_ref_c, std::is_rvalue_reference_v);
+AGREES(eden::reference_c, std::is_reference_v);
+AGREES(eden::function_c, std::is_function_v);
+AGREES(eden::class_c, std::is_class_v);
+AGREES(eden::union_c, std::is_union_v);
+AGREES(eden::enum_c, std::is_enum_v);
+AGREES(eden::scalar_c, std::is_scalar_v);
+AGREES(eden::object_c, std::is_object_v);
+AGREES(eden::const_c, std::is_const_v);
+AGREES(eden::volatile_c, std::is_volatile_v);
+
+SAME_TYPE(eden::remove_const, std::remove_const_t);
+SAME_TYPE(eden::remove_volatile, std::remove_volatile_t);
+SAME_TYPE(eden::remove_cv, std::remove_cv_t);
+SAME_TYPE(eden::remove_ref, std::remove_reference_t);
+SAME_TYPE(eden::remove_cvref, std::remove_cvref_t);
+
+static_assert(eden::same_c<int, int> && !eden::same_c<int, const int> &&
+              !eden::same_c<int, int &> && eden::same_c<Class, Class>);
+
+} // namespace
+
+int main() {}
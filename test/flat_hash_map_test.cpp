@@ -0,0 +1,118 @@
+// flat_hash_map growth: rehashing moves keys instead of copying them, and a
+// copy that throws half way through a rehash leaves the map as it was.
+//
+//   g++ -std=c++23 -O2 -fsanitize=address test/flat_hash_map_test.cpp -o hash
+//   ./hash
+#include "../flat_hash_map.hpp"
+#include <cstdio>
+#include <string>
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char *what) {
+  if (!ok) {
+    std::printf("FAIL  %s\n", what);
+    ++failures;
+  }
+}
+
+int live_keys = 0;
+int key_copies = 0;
+int copies_until_throw = -1; // -1 never throws
+
+// heap-owning key that counts copies; without NothrowMove a rehash has to
+// copy it
+template <bool NothrowMove> struct Key {
+  std::string m_name;
+
+  explicit Key(int value) : m_name("key " + std::to_string(value)) {
+    ++live_keys;
+  }
+  Key(const Key &other) : m_name(other.m_name) {
+    if (copies_until_throw == 0)
+      throw std::runtime_error("key copy");
+    if (copies_until_throw > 0)
+      --copies_until_throw;
+    ++key_copies;
+    ++live_keys;
+  }
+  Key(Key &&other) noexcept(NothrowMove) : m_name(std::move(other.m_name)) {
+    ++live_keys;
+  }
+  ~Key() { --live_keys; }
+
+  bool operator==(const Key &) const = default;
+};
+
+struct key_hash {
+  template <bool NothrowMove>
+  std::size_t operator()(const Key<NothrowMove> &key) const noexcept {
+    return std::hash<std::string>{}(key.m_name);
+  }
+};
+
+template <class Map, class K> bool has(const Map &map, const K &key, int value) {
+  const auto found = map.find(key);
+  return found != map.end() && found->second == value;
+}
+
+void moves_keys_on_rehash() {
+  key_copies = 0;
+  {
+    eden::flat_hash_map<Key<true>, int, key_hash> map;
+    for (int i{}; i < 10000; ++i)
+      map.try_emplace(Key<true>(i), i);
+
+    check(map.size() == 10000, "every key inserted");
+    check(key_copies == 0, "growing never copies a key");
+
+    bool intact = true;
+    for (int i{}; i < 10000; ++i)
+      intact = intact && has(map, Key<true>(i), i);
+    check(intact, "every key found after growing");
+  }
+  check(live_keys == 0, "every key destroyed");
+}
+
+void throwing_copy_keeps_the_map() {
+  {
+    eden::flat_hash_map<Key<false>, int, key_hash> map;
+    for (int i{}; i < 500; ++i)
+      map.try_emplace(Key<false>(i), i);
+
+    bool threw = false;
+    copies_until_throw = 100;
+    try {
+      map.reserve(4000);
+    } catch (const std::runtime_error &) {
+      threw = true;
+    }
+    copies_until_throw = -1;
+
+    check(threw, "the rehash threw");
+    check(map.size() == 500, "the size is unchanged");
+
+    bool intact = true;
+    for (int i{}; i < 500; ++i)
+      intact = intact && has(map, Key<false>(i), i);
+    check(intact, "every key found after the throw");
+
+    for (int i{500}; i < 2000; ++i)
+      map.try_emplace(Key<false>(i), i);
+    check(map.size() == 2000, "the map keeps growing afterwards");
+  }
+  check(live_keys == 0, "no key leaked");
+}
+
+} // namespace
+
+int main() {
+  moves_keys_on_rehash();
+  throwing_copy_keeps_the_map();
+
+  if (failures == 0)
+    std::printf("ok\n");
+  return failures != 0;
+}
@@ -0,0 +1,72 @@
+// huge_page_allocator behind a StackVector, past the mapping threshold. On a
+// machine without reserved huge pages this runs the fallback path, a normal
+// mapping trimmed to a 2MiB boundary.
+//
+//   g++ -std=c++23 -O2 test/huge_page_allocator_test.cpp -o huge_page_test
+//   ./huge_page_test
+#include "../stack_vector.hpp"
+#include <cstdint>
+#include <cstdio>
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char *setup, const char *what) {
+  if (!ok) {
+    std::printf("FAIL  %s: %s\n", setup, what);
+    ++failures;
+  }
+}
+
+constexpr std::size_t huge_page_size = std::size_t{2} << 20;
+
+// grows well past the 2MiB threshold, through several reallocations
+void fill_and_check(const eden::huge_page_options &options,
+                    const char *setup) {
+  using vector =
+      eden::StackVector<std::uint64_t, 16,
+                        eden::huge_page_allocator<std::uint64_t>>;
+  constexpr std::uint64_t count = 3 << 20; // 24MiB of elements
+
+  vector vec{eden::huge_page_allocator<std::uint64_t>(options)};
+  for (std::uint64_t i{}; i < count; ++i)
+    vec.push_back(i * 0x9E3779B97F4A7C15ull);
+
+  bool intact = vec.size() == count;
+  for (std::uint64_t i{}; intact && i < count; ++i)
+    intact = vec[i] == i * 0x9E3779B97F4A7C15ull;
+
+  const auto heap = reinterpret_cast<std::uintptr_t>(vec.heap_data());
+  check(intact, setup, "contents survive every reallocation");
+  check(heap % huge_page_size == 0, setup, "the heap block is 2MiB aligned");
+}
+
+} // namespace
+
+int main() {
+  fill_and_check({}, "default options");
+
+  eden::huge_page_options no_hugetlb;
+  no_hugetlb.m_try_hugetlb = false;
+  fill_and_check(no_hugetlb, "transparent huge pages only");
+
+  // mbind fails for a node that does not exist, the block is still usable
+  eden::huge_page_options absent_node;
+  absent_node.m_numa = eden::numa_policy::bind;
+  absent_node.m_node = 63;
+  fill_and_check(absent_node, "bound to an absent NUMA node");
+
+  eden::huge_page_options out_of_range_node;
+  out_of_range_node.m_numa = eden::numa_policy::preferred;
+  out_of_range_node.m_node = 4096;
+  fill_and_check(out_of_range_node, "preferring a node past the mask");
+
+  eden::huge_page_options interleaved;
+  interleaved.m_numa = eden::numa_policy::interleave;
+  fill_and_check(interleaved, "interleaved over all nodes");
+
+  if (failures == 0)
+    std::printf("ok\n");
+  return failures != 0;
+}
@@ -0,0 +1,94 @@
+// parallel_for called from outside the pool must spread its range over the
+// workers instead of running it in one piece on the caller.
+//
+//   g++ -std=c++23 -O2 -pthread test/thread_pool_test.cpp -o thread_pool_test
+//   ./thread_pool_test
+#include "../parallel_algorithms.hpp"
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <set>
+#include <thread>
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char *what) {
+  if (!ok) {
+    std::printf("FAIL  %s\n", what);
+    ++failures;
+  }
+}
+
+void splits_across_workers() {
+  eden::thread_pool pool(4);
+
+  for (int call{}; call < 200; ++call) {
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    std::size_t bodies{};
+    std::size_t covered{};
+
+    pool.parallel_for(1 << 16, 64, [&](std::size_t first, std::size_t last) {
+      {
+        std::lock_guard lock(mutex);
+        threads.insert(std::this_thread::get_id());
+        ++bodies;
+        covered += last - first;
+      }
+
+      // hold the first chunks until a second thread shows up, so one fast
+      // worker cannot finish the whole range alone, give up after a second
+      const auto deadline =
+          std::chrono::steady_clock::now() + std::chrono::seconds(1);
+      while (std::chrono::steady_clock::now() < deadline) {
+        std::lock_guard lock(mutex);
+        if (threads.size() > 1)
+          break;
+      }
+    });
+
+    check(covered == 1 << 16, "the whole range is covered exactly once");
+    check(bodies > 1, "the range runs as more than one chunk");
+    check(threads.size() > 1, "the chunks run on more than one thread");
+  }
+}
+
+void algorithms_match_serial() {
+  eden::thread_pool pool(4);
+  eden::StackVector<long, 100> vec;
+  for (long i{}; i < 100000; ++i)
+    vec.push_back((i * 7919) % 100003);
+
+  long serial{};
+  for (std::size_t i{}; i < vec.size(); ++i)
+    serial += vec[i];
+  check(eden::parallel_reduce(pool, vec, 0L) == serial, "parallel_reduce");
+
+  eden::StackVector<long, 37> out;
+  for (std::size_t i{}; i < vec.size(); ++i)
+    out.push_back(0);
+  eden::parallel_transform(pool, vec, out, [](long x) { return x + 1; });
+  bool transformed = true;
+  for (std::size_t i{}; i < vec.size(); ++i)
+    transformed &= out[i] == vec[i] + 1;
+  check(transformed, "parallel_transform");
+
+  eden::parallel_sort(pool, vec);
+  bool sorted = true;
+  for (std::size_t i{1}; i < vec.size(); ++i)
+    sorted &= vec[i - 1] <= vec[i];
+  check(sorted, "parallel_sort");
+}
+
+} // namespace
+
+int main() {
+  splits_across_workers();
+  algorithms_match_serial();
+
+  if (failures == 0)
+    std::printf("ok\n");
+  return failures != 0;
+}
@@ -0,0 +1,478 @@
+#pragma once
+#include "memory.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+namespace eden {
+
+/* Chase-Lev work-stealing deque, following the weak memory model version by
+ * Le, Pop, Cohen and Zappa Nardelli. The owning thread pushes and pops at the
+ * bottom, any other thread may steal from the top.
+ *
+ * Retired rings are kept alive until the deque is destroyed, since a thief
+ * may still be reading from one after the owner has grown past it.
+ */
+template <class T> class WorkStealingDeque {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "deque slots are read and written as atomics");
+
+  struct Ring {
+    std::int64_t m_capacity;
+    std::int64_t m_mask;
+    std::unique_ptr<std::atomic<T>[]> m_slots;
+
+    explicit Ring(std::int64_t capacity)
+        : m_capacity(capacity), m_mask(capacity - 1),
+          m_slots(new std::atomic<T>[capacity]) {}
+
+    T get(std::int64_t i) const noexcept {
+      return m_slots[i & m_mask].load(std::memory_order_relaxed);
+    }
+
+    void put(std::int64_t i, T value) noexcept {
+      m_slots[i & m_mask].store(value, std::memory_order_relaxed);
+    }
+  };
+
+  alignas(cache_line_size) std::atomic<std::int64_t> m_top{0};
+  alignas(cache_line_size) std::atomic<std::int64_t> m_bottom{0};
+  alignas(cache_line_size) std::atomic<Ring *> m_ring;
+  std::vector<std::unique_ptr<Ring>> m_rings;
+
+  Ring *grow(Ring *old, std::int64_t bottom, std::int64_t top) {
+    auto bigger = std::make_unique<Ring>(old->m_capacity * 2);
+    for (std::int64_t i = top; i < bottom; ++i)
+      bigger->put(i, old->get(i));
+
+    Ring *const raw = bigger.get();
+    m_rings.push_back(std::move(bigger));
+    m_ring.store(raw, std::memory_order_release);
+    return raw;
+  }
+
+public:
+  /* Special Member Functions */
+  explicit WorkStealingDeque(std::size_t initial_capacity = 256) {
+    std::size_t capacity = 1;
+    while (capacity < initial_capacity)
+      capacity <<= 1;
+
+    m_rings.push_back(
+        std::make_unique<Ring>(static_cast<std::int64_t>(capacity)));
+    m_ring.store(m_rings.back().get(), std::memory_order_relaxed);
+  }
+
+  WorkStealingDeque(const WorkStealingDeque &) = delete;
+  WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+  /* Special Member Functions */
+
+  // owner only
+  void push(T value) {
+    const std::int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+    const std::int64_t top = m_top.load(std::memory_order_acquire);
+    Ring *ring = m_ring.load(std::memory_order_relaxed);
+
+    if (bottom - top > ring->m_capacity - 1)
+      ring = grow(ring, bottom, top);
+
+    ring->put(bottom, value);
+    m_bottom.store(bottom + 1, std::memory_order_release);
+  }
+
+  // owner only, returns false if the deque was empty
+  bool pop(T &out) noexcept {
+    const std::int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+    Ring *const ring = m_ring.load(std::memory_order_relaxed);
+    m_bottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::int64_t top = m_top.load(std::memory_order_relaxed);
+
+    if (top > bottom) {
+      m_bottom.store(bottom + 1, std::memory_order_relaxed);
+      return false;
+    }
+
+    out = ring->get(bottom);
+    if (top != bottom)
+      return true;
+
+    // last element, race against thieves for it
+    const bool won = m_top.compare_exchange_strong(
+        top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    m_bottom.store(bottom + 1, std::memory_order_relaxed);
+    return won;
+  }
+
+  // any thread, returns false if empty or if another thread won the race
+  bool steal(T &out) noexcept {
+    std::int64_t top = m_top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const std::int64_t bottom = m_bottom.load(std::memory_order_acquire);
+
+    if (top >= bottom)
+      return false;
+
+    Ring *const ring = m_ring.load(std::memory_order_acquire);
+    out = ring->get(top);
+    return m_top.compare_exchange_strong(
+        top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] bool is_empty() const noexcept {
+    return m_bottom.load(std::memory_order_relaxed) <=
+           m_top.load(std::memory_order_relaxed);
+  }
+};
+
+/* Fixed-size pool of workers, each owning a WorkStealingDeque. Work coming
+ * from outside the pool goes through a locked injection queue; work spawned
+ * by a worker goes onto its own deque and is stolen by idle workers.
+ *
+ * The pool only deals in intrusive tasks, which keeps it allocation free on
+ * the hot path. parallel_for is the fork-join entry point the algorithms in
+ * parallel_algorithms.hpp are built on.
+ *
+ * To Do:
+ *
+ * Optional pinning of workers to cores
+ */
+class thread_pool {
+public:
+  struct task {
+    void (*execute)(task *) noexcept;
+  };
+
+private:
+  struct alignas(cache_line_size) worker {
+    WorkStealingDeque<task *> m_deque;
+    std::thread m_thread;
+    std::uint64_t m_rng_state;
+  };
+
+  static constexpr unsigned spin_rounds = 64;
+
+  std::vector<std::unique_ptr<worker>> m_workers;
+  std::mutex m_inject_mutex;
+  std::deque<task *> m_injected;
+  alignas(cache_line_size) std::atomic<std::size_t> m_injected_count{0};
+  alignas(cache_line_size) std::atomic<std::uint32_t> m_epoch{0};
+  std::atomic<std::size_t> m_sleepers{0};
+  std::atomic<bool> m_stop{false};
+
+  static inline thread_local thread_pool *t_current_pool = nullptr;
+  static inline thread_local std::size_t t_worker_index = 0;
+
+  void wake_sleepers() noexcept {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_sleepers.load(std::memory_order_relaxed) == 0)
+      return;
+
+    m_epoch.fetch_add(1, std::memory_order_release);
+    m_epoch.notify_all();
+  }
+
+  task *take_injected() {
+    if (m_injected_count.load(std::memory_order_acquire) == 0)
+      return nullptr;
+
+    std::lock_guard lock(m_inject_mutex);
+    if (m_injected.empty())
+      return nullptr;
+
+    task *const front = m_injected.front();
+    m_injected.pop_front();
+    m_injected_count.fetch_sub(1, std::memory_order_release);
+    return front;
+  }
+
+  task *steal_from_any(std::uint64_t &rng_state, std::size_t skip) noexcept {
+    const std::size_t count = m_workers.size();
+
+    // xorshift, only used to spread thieves over victims
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+
+    const std::size_t start = rng_state % count;
+    for (std::size_t i{}; i < count; ++i) {
+      const std::size_t victim = (start + i) % count;
+      if (victim == skip)
+        continue;
+
+      task *stolen;
+      if (m_workers[victim]->m_deque.steal(stolen))
+        return stolen;
+    }
+
+    return nullptr;
+  }
+
+  // takes a task from some worker's deque, for threads outside the pool
+  task *try_steal() noexcept {
+    static thread_local std::uint64_t rng_state =
+        0x2545F4914F6CDD1Dull ^ reinterpret_cast<std::uintptr_t>(&rng_state);
+    return steal_from_any(rng_state, m_workers.size());
+  }
+
+  task *find_task(std::size_t index) {
+    worker &self = *m_workers[index];
+
+    task *found;
+    if (self.m_deque.pop(found))
+      return found;
+
+    if ((found = take_injected()))
+      return found;
+
+    return steal_from_any(self.m_rng_state, index);
+  }
+
+  void worker_loop(std::size_t index) {
+    t_current_pool = this;
+    t_worker_index = index;
+
+    while (!m_stop.load(std::memory_order_acquire)) {
+      task *found = nullptr;
+      for (unsigned round{}; round < spin_rounds && !found; ++round) {
+        found = find_task(index);
+        if (!found)
+          std::this_thread::yield();
+      }
+
+      if (found) {
+        found->execute(found);
+        continue;
+      }
+
+      m_sleepers.fetch_add(1, std::memory_order_seq_cst);
+      const std::uint32_t epoch = m_epoch.load(std::memory_order_acquire);
+      found = find_task(index);
+      if (!found && !m_stop.load(std::memory_order_acquire))
+        m_epoch.wait(epoch, std::memory_order_acquire);
+      m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+
+      if (found)
+        found->execute(found);
+    }
+  }
+
+public:
+  /* Special Member Functions */
+  explicit thread_pool(
+      std::size_t num_threads = std::max(1u, std::thread::hardware_concurrency()))
+      : m_workers(std::max<std::size_t>(num_threads, 1)) {
+    std::uint64_t seed = 0x9E3779B97F4A7C15ull;
+    for (auto &slot : m_workers) {
+      slot = std::make_unique<worker>();
+      slot->m_rng_state = seed += 0x9E3779B97F4A7C15ull;
+    }
+
+    for (std::size_t i{}; i < m_workers.size(); ++i)
+      m_workers[i]->m_thread = std::thread([this, i] { worker_loop(i); });
+  }
+
+  thread_pool(const thread_pool &) = delete;
+  thread_pool &operator=(const thread_pool &) = delete;
+
+  ~thread_pool() noexcept {
+    m_stop.store(true, std::memory_order_release);
+    m_epoch.fetch_add(1, std::memory_order_release);
+    m_epoch.notify_all();
+
+    for (auto &w : m_workers)
+      w->m_thread.join();
+  }
+  /* Special Member Functions */
+
+  [[nodiscard]] std::size_t size() const noexcept { return m_workers.size(); }
+
+  // true when called from one of this pool's workers
+  [[nodiscard]] bool in_worker() const noexcept {
+    return t_current_pool == this;
+  }
+
+  /* Scheduling */
+  // the task must stay alive until it has executed
+  void submit(task *t) {
+    if (in_worker()) {
+      m_workers[t_worker_index]->m_deque.push(t);
+    } else {
+      std::lock_guard lock(m_inject_mutex);
+      m_injected.push_back(t);
+      m_injected_count.fetch_add(1, std::memory_order_release);
+    }
+
+    wake_sleepers();
+  }
+
+  // puts tasks [first, last) on the injection queue in one go, all of them
+  // or, if this throws, none
+  template <class It> void submit_all(It first, It last) {
+    {
+      std::lock_guard lock(m_inject_mutex);
+      const std::size_t before = m_injected.size();
+      m_injected.insert(m_injected.end(), first, last);
+      m_injected_count.fetch_add(m_injected.size() - before,
+                                 std::memory_order_release);
+    }
+
+    wake_sleepers();
+  }
+
+  // runs a single pending task on the calling thread, if one is available
+  bool try_run_one() {
+    task *found;
+    if (in_worker())
+      found = find_task(t_worker_index);
+    else if (!(found = take_injected()))
+      found = try_steal();
+
+    if (!found)
+      return false;
+
+    found->execute(found);
+    return true;
+  }
+
+  /* Calls body(first, last) over disjoint subranges covering [0, count),
+   * where every boundary except count is a multiple of grain. Ranges are
+   * split in half lazily by whichever thread runs them, so idle workers
+   * steal large pieces first. Called from outside the pool, the range is
+   * first cut into one piece per worker and queued, and the calling thread
+   * then only helps by stealing, so the pieces land on the workers instead
+   * of back on the caller. The first exception thrown by body is rethrown
+   * here.
+   */
+  template <class Body>
+  void parallel_for(std::size_t count, std::size_t grain, Body &&body);
+  /* Scheduling */
+};
+
+namespace parallel_detail {
+
+template <class Body> struct for_job;
+
+template <class Body> struct range_task : thread_pool::task {
+  for_job<Body> *m_job;
+  std::size_t m_first_chunk;
+  std::size_t m_last_chunk;
+
+  static void run(thread_pool::task *base) noexcept;
+};
+
+template <class Body> struct for_job {
+  thread_pool &m_pool;
+  Body &m_body;
+  std::size_t m_count;
+  std::size_t m_grain;
+  std::unique_ptr<range_task<Body>[]> m_tasks;
+  std::atomic<std::size_t> m_next_task{0};
+  alignas(cache_line_size) std::atomic<std::size_t> m_chunks_left;
+  std::atomic<bool> m_failed{false};
+  std::exception_ptr m_exception;
+
+  for_job(thread_pool &pool, Body &body, std::size_t count,
+          std::size_t grain, std::size_t num_chunks)
+      : m_pool(pool), m_body(body), m_count(count), m_grain(grain),
+        m_tasks(std::make_unique<range_task<Body>[]>(num_chunks)),
+        m_chunks_left(num_chunks) {}
+
+  range_task<Body> *make_task(std::size_t first_chunk,
+                              std::size_t last_chunk) noexcept {
+    range_task<Body> &t =
+        m_tasks[m_next_task.fetch_add(1, std::memory_order_relaxed)];
+    t.execute = &range_task<Body>::run;
+    t.m_job = this;
+    t.m_first_chunk = first_chunk;
+    t.m_last_chunk = last_chunk;
+    return &t;
+  }
+};
+
+template <class Body>
+void range_task<Body>::run(thread_pool::task *base) noexcept {
+  auto *const self = static_cast<range_task *>(base);
+  for_job<Body> &job = *self->m_job;
+  std::size_t first = self->m_first_chunk;
+  std::size_t last = self->m_last_chunk;
+
+  // workers split onto their own deque, other threads onto the injection
+  // queue
+  while (last - first > 1) {
+    const std::size_t mid = first + (last - first) / 2;
+    try {
+      job.m_pool.submit(job.make_task(mid, last));
+    } catch (...) {
+      break;
+    }
+    last = mid;
+  }
+
+  if (!job.m_failed.load(std::memory_order_relaxed)) {
+    try {
+      job.m_body(first * job.m_grain, std::min(last * job.m_grain, job.m_count));
+    } catch (...) {
+      if (!job.m_failed.exchange(true, std::memory_order_acq_rel))
+        job.m_exception = std::current_exception();
+    }
+  }
+
+  // must be the last access to job, the owner may return right after
+  job.m_chunks_left.fetch_sub(last - first, std::memory_order_acq_rel);
+}
+
+} // namespace parallel_detail
+
+template <class Body>
+void thread_pool::parallel_for(std::size_t count, std::size_t grain,
+                               Body &&body) {
+  if (count == 0)
+    return;
+
+  grain = std::max<std::size_t>(grain, 1);
+  const std::size_t num_chunks = (count - 1) / grain + 1;
+  if (num_chunks == 1 || size() == 1) {
+    body(std::size_t{0}, count);
+    return;
+  }
+
+  using body_type = std::remove_reference_t<Body>;
+  parallel_detail::for_job<body_type> job(*this, body, count, grain,
+                                          num_chunks);
+
+  if (in_worker()) {
+    submit(job.make_task(0, num_chunks));
+    while (job.m_chunks_left.load(std::memory_order_acquire) != 0) {
+      if (!try_run_one())
+        std::this_thread::yield();
+    }
+  } else {
+    // taking the root back off the injection queue would run it here, on a
+    // thread that is not a worker
+    const std::size_t pieces = std::min(size(), num_chunks);
+    std::vector<task *> roots(pieces);
+    for (std::size_t p{}; p < pieces; ++p)
+      roots[p] = job.make_task(num_chunks * p / pieces,
+                               num_chunks * (p + 1) / pieces);
+    submit_all(roots.begin(), roots.end());
+
+    while (job.m_chunks_left.load(std::memory_order_acquire) != 0) {
+      if (task *stolen = try_steal())
+        stolen->execute(stolen);
+      else
+        std::this_thread::yield();
+    }
+  }
+
+  if (job.m_exception)
+    std::rethrow_exception(job.m_exception);
+}
+
+} // namespace eden
@@ -0,0 +1,551 @@
+#pragma once
+#include "memory.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if __has_include(<execinfo.h>)
+#include <execinfo.h>
+#define EDEN_HAS_BACKTRACE 1
+#else
+#define EDEN_HAS_BACKTRACE 0
+#endif
+
+namespace eden {
+
+// handle to a name registered with allocation_tracker::tag
+class allocation_tag {
+  std::uint32_t m_id{0};
+
+  friend class allocation_tracker;
+  explicit constexpr allocation_tag(std::uint32_t id) noexcept : m_id(id) {}
+
+public:
+  // the "untagged" tag
+  constexpr allocation_tag() noexcept = default;
+
+  [[nodiscard]] constexpr std::uint32_t id() const noexcept { return m_id; }
+  constexpr bool operator==(const allocation_tag &other) const noexcept =
+      default;
+};
+
+inline constexpr std::size_t allocation_histogram_buckets = 16;
+
+// histogram bucket i counts requests of at most 16 << i bytes, the last
+// bucket everything larger
+constexpr std::size_t allocation_bucket_for(std::size_t bytes) noexcept {
+  if (bytes <= 16)
+    return 0;
+  return std::min<std::size_t>(std::bit_width(bytes - 1) - 4,
+                               allocation_histogram_buckets - 1);
+}
+
+struct allocation_stats {
+  std::string m_tag;
+  std::uint64_t m_allocations{0};
+  std::uint64_t m_deallocations{0};
+  std::uint64_t m_bytes{0}; // total ever allocated
+  std::uint64_t m_live_bytes{0};
+  std::uint64_t m_peak_bytes{0};
+  std::array<std::uint64_t, allocation_histogram_buckets> m_histogram{};
+};
+
+struct allocation_sample {
+  std::string m_tag;
+  std::size_t m_bytes{0};
+  std::vector<void *> m_frames; // innermost first
+};
+
+struct allocation_snapshot {
+  std::vector<allocation_stats> m_tags;
+  std::vector<allocation_sample> m_samples;
+
+  // tags without any allocation are left out, frames are symbolised with
+  // backtrace_symbols where available
+  [[nodiscard]] std::string to_json() const;
+};
+
+/* Process wide counters behind tracking_allocator.
+ *
+ * Every thread owns a block of counters, one entry per tag, that only it
+ * writes, so counting an allocation is a handful of relaxed loads and stores
+ * with no shared cache line. snapshot() sums the blocks under a mutex, and a
+ * thread that exits folds its block into the retired totals.
+ *
+ * Live and peak bytes need a shared view: each thread keeps a pending change
+ * in live bytes per tag and pushes it to a shared atomic whenever it moves by
+ * live_flush_bytes, which is also when the peak is updated. The peak is
+ * therefore exact to within live_flush_bytes per thread, and live bytes are
+ * exact whenever no thread is allocating.
+ *
+ * With a sample interval set, roughly one allocation per that many bytes
+ * records its stack, and the last max_samples records are kept.
+ */
+class allocation_tracker {
+public:
+  static constexpr std::size_t max_tags = 64;
+  static constexpr std::size_t max_samples = 4096;
+  static constexpr std::size_t max_frames = 32;
+  static constexpr std::int64_t live_flush_bytes = 64 * 1024;
+
+private:
+  struct tag_counters {
+    std::atomic<std::uint64_t> m_allocations{0};
+    std::atomic<std::uint64_t> m_deallocations{0};
+    std::atomic<std::uint64_t> m_bytes{0};
+    std::atomic<std::int64_t> m_pending_live{0};
+    std::array<std::atomic<std::uint64_t>, allocation_histogram_buckets>
+        m_histogram{};
+  };
+
+  struct alignas(cache_line_size) thread_block {
+    std::array<tag_counters, max_tags> m_tags;
+    std::int64_t m_until_sample{0};
+    thread_block *m_next{nullptr};
+  };
+
+  struct alignas(cache_line_size) shared_live {
+    std::atomic<std::int64_t> m_live{0};
+    std::atomic<std::int64_t> m_peak{0};
+  };
+
+  struct retired_counters {
+    std::uint64_t m_allocations{0};
+    std::uint64_t m_deallocations{0};
+    std::uint64_t m_bytes{0};
+    std::array<std::uint64_t, allocation_histogram_buckets> m_histogram{};
+  };
+
+  struct raw_sample {
+    std::uint32_t m_tag;
+    std::size_t m_bytes;
+    std::size_t m_depth;
+    std::array<void *, max_frames> m_frames;
+  };
+
+  // unregisters the block of the thread it belongs to when the thread exits
+  struct thread_slot {
+    thread_block *m_block{nullptr};
+    ~thread_slot() {
+      if (m_block)
+        instance().retire(m_block);
+    }
+  };
+
+  static inline thread_local thread_block *t_block = nullptr;
+  // set when the thread's block is retired, later allocations on the thread
+  // (from other thread_local destructors) are not counted
+  static inline thread_local bool t_exited = false;
+
+  std::mutex m_mutex;
+  std::atomic<std::uint32_t> m_tag_count{1};
+  std::array<std::string, max_tags> m_names{"untagged"};
+  std::array<shared_live, max_tags> m_live;
+  std::array<retired_counters, max_tags> m_retired;
+  thread_block *m_threads{nullptr};
+  std::atomic<std::size_t> m_sample_interval{0};
+  std::vector<raw_sample> m_samples;
+  std::size_t m_next_sample{0};
+
+  allocation_tracker() = default;
+
+  // single writer, so no read-modify-write is needed
+  template <class T>
+  static void bump(std::atomic<T> &counter, T by) noexcept {
+    counter.store(counter.load(std::memory_order_relaxed) + by,
+                  std::memory_order_relaxed);
+  }
+
+  // nullptr once the thread has exited or if its block could not be made
+  thread_block *local_block() noexcept {
+    if (t_block) [[likely]]
+      return t_block;
+    if (t_exited)
+      return nullptr;
+
+    static thread_local thread_slot slot;
+    auto *const block = new (std::nothrow) thread_block;
+    if (!block)
+      return nullptr;
+
+    block->m_until_sample = static_cast<std::int64_t>(
+        m_sample_interval.load(std::memory_order_relaxed));
+    {
+      std::lock_guard lock(m_mutex);
+      block->m_next = m_threads;
+      m_threads = block;
+    }
+
+    slot.m_block = block;
+    t_block = block;
+    return block;
+  }
+
+  void flush_live(std::uint32_t tag, std::int64_t pending) noexcept {
+    shared_live &shared = m_live[tag];
+    const std::int64_t live =
+        shared.m_live.fetch_add(pending, std::memory_order_relaxed) + pending;
+
+    std::int64_t peak = shared.m_peak.load(std::memory_order_relaxed);
+    while (live > peak && !shared.m_peak.compare_exchange_weak(
+                              peak, live, std::memory_order_relaxed))
+      ;
+  }
+
+  void update_live(tag_counters &counters, std::uint32_t tag,
+                   std::int64_t by) noexcept {
+    const std::int64_t pending =
+        counters.m_pending_live.load(std::memory_order_relaxed) + by;
+    if (pending >= live_flush_bytes || pending <= -live_flush_bytes) {
+      flush_live(tag, pending);
+      counters.m_pending_live.store(0, std::memory_order_relaxed);
+    } else {
+      counters.m_pending_live.store(pending, std::memory_order_relaxed);
+    }
+  }
+
+  void retire(thread_block *block) noexcept {
+    std::lock_guard lock(m_mutex);
+
+    for (thread_block **link = &m_threads; *link; link = &(*link)->m_next) {
+      if (*link == block) {
+        *link = block->m_next;
+        break;
+      }
+    }
+
+    for (std::size_t tag{}; tag < max_tags; ++tag) {
+      tag_counters &counters = block->m_tags[tag];
+      retired_counters &retired = m_retired[tag];
+      retired.m_allocations += counters.m_allocations.load();
+      retired.m_deallocations += counters.m_deallocations.load();
+      retired.m_bytes += counters.m_bytes.load();
+      for (std::size_t b{}; b < allocation_histogram_buckets; ++b)
+        retired.m_histogram[b] += counters.m_histogram[b].load();
+
+      if (const std::int64_t pending = counters.m_pending_live.load())
+        flush_live(static_cast<std::uint32_t>(tag), pending);
+    }
+
+    t_block = nullptr;
+    t_exited = true;
+    delete block;
+  }
+
+  void take_sample(std::uint32_t tag, std::size_t bytes) noexcept {
+    raw_sample sample{tag, bytes, 0, {}};
+#if EDEN_HAS_BACKTRACE
+    sample.m_depth = static_cast<std::size_t>(
+        backtrace(sample.m_frames.data(), static_cast<int>(max_frames)));
+#endif
+
+    std::lock_guard lock(m_mutex);
+    try {
+      if (m_samples.size() < max_samples)
+        m_samples.push_back(sample);
+      else
+        m_samples[m_next_sample] = sample;
+      m_next_sample = (m_next_sample + 1) % max_samples;
+    } catch (...) {
+      // a lost sample is not worth failing the allocation over
+    }
+  }
+
+public:
+  allocation_tracker(const allocation_tracker &other) = delete;
+  allocation_tracker &operator=(const allocation_tracker &other) = delete;
+
+  static allocation_tracker &instance() {
+    static allocation_tracker tracker;
+    return tracker;
+  }
+
+  // the tag called name, registered on first use
+  allocation_tag tag(std::string_view name) {
+    std::lock_guard lock(m_mutex);
+    const std::uint32_t count = m_tag_count.load(std::memory_order_relaxed);
+
+    for (std::uint32_t i{}; i < count; ++i)
+      if (m_names[i] == name)
+        return allocation_tag(i);
+
+    if (count == max_tags)
+      throw std::runtime_error("too many allocation tags");
+
+    m_names[count] = name;
+    m_tag_count.store(count + 1, std::memory_order_release);
+    return allocation_tag(count);
+  }
+
+  // sample about one allocation per bytes allocated, 0 turns sampling off
+  void set_sample_interval(std::size_t bytes) noexcept {
+    m_sample_interval.store(bytes, std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] std::size_t sample_interval() const noexcept {
+    return m_sample_interval.load(std::memory_order_relaxed);
+  }
+
+  void record_allocation(allocation_tag tag, std::size_t bytes) noexcept {
+    thread_block *const block = local_block();
+    if (!block)
+      return;
+
+    tag_counters &counters = block->m_tags[tag.id()];
+    bump(counters.m_allocations, std::uint64_t{1});
+    bump(counters.m_bytes, std::uint64_t{bytes});
+    bump(counters.m_histogram[allocation_bucket_for(bytes)], std::uint64_t{1});
+    update_live(counters, tag.id(), static_cast<std::int64_t>(bytes));
+
+    const std::size_t interval =
+        m_sample_interval.load(std::memory_order_relaxed);
+    if (interval) [[unlikely]] {
+      block->m_until_sample -= static_cast<std::int64_t>(bytes);
+      if (block->m_until_sample <= 0) {
+        block->m_until_sample = static_cast<std::int64_t>(interval);
+        take_sample(tag.id(), bytes);
+      }
+    }
+  }
+
+  void record_deallocation(allocation_tag tag, std::size_t bytes) noexcept {
+    thread_block *const block = local_block();
+    if (!block)
+      return;
+
+    tag_counters &counters = block->m_tags[tag.id()];
+    bump(counters.m_deallocations, std::uint64_t{1});
+    update_live(counters, tag.id(), -static_cast<std::int64_t>(bytes));
+  }
+
+  [[nodiscard]] allocation_snapshot snapshot() {
+    allocation_snapshot ret_val;
+    std::lock_guard lock(m_mutex);
+    const std::uint32_t count = m_tag_count.load(std::memory_order_relaxed);
+
+    ret_val.m_tags.resize(count);
+    for (std::uint32_t tag{}; tag < count; ++tag) {
+      allocation_stats &stats = ret_val.m_tags[tag];
+      const retired_counters &retired = m_retired[tag];
+      stats.m_tag = m_names[tag];
+      stats.m_allocations = retired.m_allocations;
+      stats.m_deallocations = retired.m_deallocations;
+      stats.m_bytes = retired.m_bytes;
+      stats.m_histogram = retired.m_histogram;
+
+      std::int64_t live = m_live[tag].m_live.load(std::memory_order_relaxed);
+      for (thread_block *block = m_threads; block; block = block->m_next) {
+        const tag_counters &counters = block->m_tags[tag];
+        stats.m_allocations +=
+            counters.m_allocations.load(std::memory_order_relaxed);
+        stats.m_deallocations +=
+            counters.m_deallocations.load(std::memory_order_relaxed);
+        stats.m_bytes += counters.m_bytes.load(std::memory_order_relaxed);
+        live += counters.m_pending_live.load(std::memory_order_relaxed);
+        for (std::size_t b{}; b < allocation_histogram_buckets; ++b)
+          stats.m_histogram[b] +=
+              counters.m_histogram[b].load(std::memory_order_relaxed);
+      }
+
+      const std::int64_t peak =
+          m_live[tag].m_peak.load(std::memory_order_relaxed);
+      stats.m_live_bytes =
+          static_cast<std::uint64_t>(std::max<std::int64_t>(live, 0));
+      stats.m_peak_bytes = static_cast<std::uint64_t>(std::max(peak, live));
+    }
+
+    // oldest first
+    ret_val.m_samples.reserve(m_samples.size());
+    for (std::size_t i{}; i < m_samples.size(); ++i) {
+      const raw_sample &raw =
+          m_samples[(m_next_sample + i) % m_samples.size()];
+      ret_val.m_samples.push_back(
+          {m_names[raw.m_tag], raw.m_bytes,
+           std::vector<void *>(raw.m_frames.begin(),
+                               raw.m_frames.begin() + raw.m_depth)});
+    }
+
+    return ret_val;
+  }
+
+  void clear_samples() {
+    std::lock_guard lock(m_mutex);
+    m_samples.clear();
+    m_next_sample = 0;
+  }
+};
+
+/* Allocator adapter that forwards to Inner and counts every allocation
+ * against a tag in allocation_tracker. It keeps the interface of
+ * eden::allocator, so it can be handed to StackVector and the other
+ * containers here:
+ *
+ *   const auto edges = allocation_tracker::instance().tag("edges");
+ *   using alloc = tracking_allocator<allocator<int>>;
+ *   StackVector<int, 16, alloc> v{alloc(edges)};
+ *   ...
+ *   std::puts(allocation_tracker::instance().snapshot().to_json().c_str());
+ *
+ * Failed allocations are not counted.
+ */
+template <class Inner> class tracking_allocator {
+  using value_type =
+      std::remove_pointer_t<decltype(std::declval<Inner &>().allocate(1))>;
+
+  [[no_unique_address]] Inner m_inner;
+  allocation_tag m_tag;
+
+public:
+  constexpr tracking_allocator() noexcept(noexcept(Inner())) = default;
+  explicit constexpr tracking_allocator(allocation_tag tag,
+                                        const Inner &inner = Inner()) noexcept(
+      std::is_nothrow_copy_constructible_v<Inner>)
+      : m_inner(inner), m_tag(tag) {}
+  constexpr tracking_allocator(const tracking_allocator &other) = default;
+  constexpr tracking_allocator(tracking_allocator &&other) = default;
+  constexpr tracking_allocator &
+  operator=(const tracking_allocator &other) = default;
+  constexpr tracking_allocator &operator=(tracking_allocator &&other) = default;
+  constexpr ~tracking_allocator() noexcept {}
+
+  [[nodiscard]] constexpr allocation_tag tag() const noexcept { return m_tag; }
+  [[nodiscard]] constexpr const Inner &inner() const noexcept {
+    return m_inner;
+  }
+
+  // returns nullptr on allocation failure
+  value_type *allocate(std::size_t n) noexcept(
+      noexcept(std::declval<Inner &>().allocate(n))) {
+    value_type *const p = m_inner.allocate(n);
+    if (p)
+      allocation_tracker::instance().record_allocation(m_tag,
+                                                       n * sizeof(value_type));
+    return p;
+  }
+
+  void deallocate(value_type *p, std::size_t n) noexcept(
+      noexcept(std::declval<Inner &>().deallocate(p, n))) {
+    if (p)
+      allocation_tracker::instance().record_deallocation(
+          m_tag, n * sizeof(value_type));
+    m_inner.deallocate(p, n);
+  }
+};
+
+namespace tracking_detail {
+inline void append_json_string(std::string &out, std::string_view text) {
+  out.push_back('"');
+  for (const char c : text) {
+    switch (c) {
+    case '"':
+      out += "\\\"";
+      break;
+    case '\\':
+      out += "\\\\";
+      break;
+    case '\n':
+      out += "\\n";
+      break;
+    case '\t':
+      out += "\\t";
+      break;
+    default:
+      if (static_cast<unsigned char>(c) < 0x20) {
+        char escaped[7];
+        std::snprintf(escaped, sizeof(escaped), "\\u%04x",
+                      static_cast<unsigned>(c));
+        out += escaped;
+      } else {
+        out.push_back(c);
+      }
+    }
+  }
+  out.push_back('"');
+}
+} // namespace tracking_detail
+
+inline std::string allocation_snapshot::to_json() const {
+  std::string out = "{\"tags\":[";
+  bool first = true;
+
+  for (const allocation_stats &stats : m_tags) {
+    if (stats.m_allocations == 0)
+      continue;
+
+    out += first ? "" : ",";
+    first = false;
+    out += "{\"tag\":";
+    tracking_detail::append_json_string(out, stats.m_tag);
+    out += ",\"allocations\":" + std::to_string(stats.m_allocations);
+    out += ",\"deallocations\":" + std::to_string(stats.m_deallocations);
+    out += ",\"bytes\":" + std::to_string(stats.m_bytes);
+    out += ",\"live_bytes\":" + std::to_string(stats.m_live_bytes);
+    out += ",\"peak_bytes\":" + std::to_string(stats.m_peak_bytes);
+
+    // keyed by the largest size in the bucket
+    out += ",\"histogram\":{";
+    bool first_bucket = true;
+    for (std::size_t b{}; b < allocation_histogram_buckets; ++b) {
+      if (stats.m_histogram[b] == 0)
+        continue;
+
+      out += first_bucket ? "\"" : ",\"";
+      first_bucket = false;
+      out += b + 1 == allocation_histogram_buckets
+                 ? std::string("inf")
+                 : std::to_string(std::size_t{16} << b);
+      out += "\":" + std::to_string(stats.m_histogram[b]);
+    }
+    out += "}}";
+  }
+
+  out += "],\"samples\":[";
+  for (std::size_t i{}; i < m_samples.size(); ++i) {
+    const allocation_sample &sample = m_samples[i];
+    out += i ? ",{\"tag\":" : "{\"tag\":";
+    tracking_detail::append_json_string(out, sample.m_tag);
+    out += ",\"bytes\":" + std::to_string(sample.m_bytes);
+    out += ",\"frames\":[";
+
+#if EDEN_HAS_BACKTRACE
+    char **const symbols =
+        sample.m_frames.empty()
+            ? nullptr
+            : backtrace_symbols(sample.m_frames.data(),
+                                static_cast<int>(sample.m_frames.size()));
+#endif
+    for (std::size_t f{}; f < sample.m_frames.size(); ++f) {
+      out += f ? "," : "";
+#if EDEN_HAS_BACKTRACE
+      if (symbols) {
+        tracking_detail::append_json_string(out, symbols[f]);
+        continue;
+      }
+#endif
+      char address[2 + 2 * sizeof(void *) + 1];
+      std::snprintf(address, sizeof(address), "%p", sample.m_frames[f]);
+      tracking_detail::append_json_string(out, address);
+    }
+#if EDEN_HAS_BACKTRACE
+    std::free(symbols);
+#endif
+    out += "]}";
+  }
+
+  out += "]}";
+  return out;
+}
+
+} // namespace eden
@@ -1,7 +1,25 @@
 #pragma once
+#include <cstddef>
+
+/* Traits and concepts map onto compiler builtins when they are available,
+ * which saves a class template instantiation per check and adds up quickly
+ * in heavily templated code. Define EDEN_NO_BUILTIN_TRAITS to force the
+ * portable implementations, e.g. to compare the two. Both give the same
+ * answer for every type, so the choice never changes overload resolution.
+ */
+#if defined(__has_builtin) && !defined(EDEN_NO_BUILTIN_TRAITS)
+#define EDEN_HAS_BUILTIN(builtin) __has_builtin(builtin)
+#else
+#define EDEN_HAS_BUILTIN(builtin) 0
+#endif
 
 namespace eden {
 
+#if EDEN_HAS_BUILTIN(__is_same)
+template <class First, class Second> struct is_same_struct {
+  static constexpr bool value = __is_same(First, Second);
+};
+#else
 template <class Diff_first, class Diff_second> struct is_same_struct {
   static constexpr bool value = false;
 };
@@ -9,6 +27,35 @@ template <class Diff_first, class Diff_second> struct is_same_struct {
 template <class Same> struct is_same_struct<Same, Same> {
   static constexpr bool value = true;
 };
+#endif
+
+template <class T> struct is_pointer_struct {
+  static constexpr bool value = false;
+};
+
+template <class T> struct is_pointer_struct<T *> {
+  static constexpr bool value = true;
+};
+
+template <class T> struct is_member_pointer_struct {
+  static constexpr bool value = false;
+};
+
+template <class T, class Class> struct is_member_pointer_struct<T Class::*> {
+  static constexpr bool value = true;
+};
+
+template <class T> struct is_array_struct {
+  static constexpr bool value = false;
+};
+
+template <class T> struct is_array_struct<T[]> {
+  static constexpr bool value = true;
+};
+
+template <class T, std::size_t N> struct is_array_struct<T[N]> {
+  static constexpr bool value = true;
+};
 
 template <class T> struct remove_const_struct {
   typedef T type;
@@ -26,9 +73,23 @@ template <class T> struct remove_volatile_struct<volatile T> {
   typedef T type;
 };
 
+#if EDEN_HAS_BUILTIN(__remove_const)
+template <class T> using remove_const = __remove_const(T);
+#else
 template <class T> using remove_const = remove_const_struct<T>::type;
+#endif
+
+#if EDEN_HAS_BUILTIN(__remove_volatile)
+template <class T> using remove_volatile = __remove_volatile(T);
+#else
 template <class T> using remove_volatile = remove_volatile_struct<T>::type;
+#endif
+
+#if EDEN_HAS_BUILTIN(__remove_cv)
+template <class T> using remove_cv = __remove_cv(T);
+#else
 template <class T> using remove_cv = remove_const<remove_volatile<T>>;
+#endif
 
 template <class T> struct remove_ref_struct {
   typedef T type;
@@ -42,8 +103,20 @@ template <class T> struct remove_ref_struct<T &&> {
   typedef T type;
 };
 
+#if EDEN_HAS_BUILTIN(__remove_reference_t)
+template <class T> using remove_ref = __remove_reference_t(T);
+#elif EDEN_HAS_BUILTIN(__remove_reference)
+template <class T> using remove_ref = __remove_reference(T);
+#else
 template <class T> using remove_ref = remove_ref_struct<T>::type;
-template <class T> using remove_cvref = remove_ref<remove_cv<T>>;
+#endif
+
+#if EDEN_HAS_BUILTIN(__remove_cvref)
+template <class T> using remove_cvref = __remove_cvref(T);
+#else
+template <class T> using remove_cvref = remove_cv<remove_ref<T>>;
+#endif
+
 template <class T> using add_rval_ref = T &&;
 template <class T> using add_lval_ref = T &;
 